@@ -32,7 +32,12 @@ function getJSType(py_array) {
 function toTypedArray(py_array) {
   const cons = getJSType(py_array);
 
-  return new cons(py_array.toJS().buffer);
+  // The character typecodes have no struct format equivalent
+  // and are not supported by the native conversion
+  const typecode = py_array.typecode.toJS();
+  if (typecode === 'u' || typecode === 'w') return new cons(py_array.toJS().buffer);
+
+  return py_array.toTypedArray();
 }
 
 const pythonTypes = {
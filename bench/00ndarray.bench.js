@@ -27,6 +27,29 @@ const js_fn = new Function('np', 'size', `
   return b;
 `);
 
+const js_method_fn = new Function('np', 'size', `
+  let b = 0;
+  for (let i = 0; i < 100; i++) {
+    const a = np.callMethod('matmul', np.callMethod('arange', size * size * 2)
+        .callMethod('reshape', [size, size * 2]).get('T'),
+      np.callMethod('arange', size * size * 2).callMethod('reshape', [size, size * 2]));
+    b += np.callMethod('average', a).callMethod('item').toJS();
+  }
+  return b;
+`);
+
+const lazy_np = pymport.lazy(np);
+
+const js_lazy_fn = new Function('np', 'size', `
+  let b = 0;
+  for (let i = 0; i < 100; i++) {
+    const a = np.matmul(np.arange(size * size * 2).reshape([size, size * 2]).T,
+      np.arange(size * size * 2).reshape([size, size * 2]));
+    b += np.average(a).get('item')().toJS();
+  }
+  return b;
+`);
+
 module.exports = function (size) {
   return b.suite(
     `100 mul/100 reduce, arrays of ${size}x${size * 2} elements`,
@@ -40,6 +63,12 @@ module.exports = function (size) {
     b.add('Node.js raw', () => {
       js_fn(np, size);
     }),
+    b.add('Node.js callMethod', () => {
+      js_method_fn(np, size);
+    }),
+    b.add('Node.js lazy', () => {
+      js_lazy_fn(lazy_np, size);
+    }),
     b.cycle(),
     b.complete()
   );
@@ -0,0 +1,40 @@
+const b = require('benny');
+const { PyObject, pyval } = require('..');
+
+// Object Store throughput with a large number of live wrappers
+// size is the number of live wrappers in thousands:
+// node bench/bench.js 10,100,1000 objstore
+module.exports = function (size) {
+  const live = size * 1000;
+
+  // Python objects that are kept wrapped during the whole benchmark
+  const py_live = pyval(`[object() for _ in range(${live})]`);
+  const js_live = new Array(live);
+  for (let i = 0; i < live; i++) js_live[i] = py_live.item(i);
+
+  // Creates new Python objects that are wrapped and released by the GC during the benchmark
+  const py_object = pyval('object');
+
+  let idx = 0;
+  return b.suite(
+    `Object Store with ${live} live objects`,
+
+    b.add('retrieve 1000 live wrappers', () => {
+      for (let i = 0; i < 1000; i++) {
+        py_live.item(idx);
+        idx = (idx + 7919) % live;
+      }
+    }),
+    b.add('wrap 1000 new objects', () => {
+      for (let i = 0; i < 1000; i++) py_object.call();
+    }),
+    b.add('wrap 1000 new ints', () => {
+      for (let i = 0; i < 1000; i++) PyObject.int(live + i);
+    }),
+    b.cycle(),
+    b.complete(() => {
+      // Keep the live wrappers until the end
+      js_live.length = 0;
+    })
+  );
+};
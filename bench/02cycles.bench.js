@@ -0,0 +1,42 @@
+const { pymport, pyval, collectCycles } = require('..');
+
+// Leak benchmark for JS <-> Python reference cycles
+// size is the number of cycles in thousands:
+// node --expose-gc bench/bench.js 10,100 cycles
+const gc = pymport('gc');
+
+function createCycles(n) {
+  for (let i = 0; i < n; i++) {
+    const obj = pyval('type("Holder", (), {})()');
+    pyval('setattr(o, "cb", f)', { o: obj, f: () => obj.toString() });
+  }
+}
+
+function liveObjects() {
+  if (global.gc) {
+    global.gc();
+    global.gc();
+  }
+  gc.get('collect').call();
+  return gc.get('get_objects').call().length;
+}
+
+module.exports = async function (size) {
+  const cycles = size * 1000;
+
+  for (const collect of [false, true]) {
+    const before = liveObjects();
+    const start = process.hrtime.bigint();
+    for (let i = 0; i < cycles; i += 1000) {
+      createCycles(1000);
+      if (collect) collectCycles();
+      // Let the finalizers run
+      // eslint-disable-next-line no-await-in-loop
+      await new Promise((resolve) => setImmediate(resolve));
+    }
+    const elapsed = Number(process.hrtime.bigint() - start) / 1e6;
+    const after = liveObjects();
+    console.log(`${cycles} cycles, collectCycles ${collect ? 'every 1000 cycles' : 'never'}: ` +
+      `${after - before} Python objects leaked, ${elapsed.toFixed(0)} ms`);
+  }
+};
@@ -0,0 +1,34 @@
+const b = require('benny');
+const { PyObject } = require('..');
+
+// JS to Python conversion of object graphs
+// size is the number of objects in thousands:
+// node bench/bench.js 1,10,100 fromjs
+module.exports = function (size) {
+  const count = size * 1000;
+
+  // Every object is a container that must be checked for circular references
+  const records = new Array(count);
+  for (let i = 0; i < count; i++) records[i] = { id: i, name: `record ${i}`, tags: ['a', 'b'] };
+
+  // Strings and numbers only, no containers
+  const scalars = new Array(count);
+  for (let i = 0; i < count; i++) scalars[i] = i % 2 ? `string ${i}` : i;
+
+  const converter = PyObject.compileConverter([{ id: 'int', name: 'str', tags: ['str'] }]);
+
+  return b.suite(
+    `JS to Python conversion of ${count} objects`,
+
+    b.add('array of objects', () => {
+      PyObject.fromJS(records);
+    }),
+    b.add('array of objects, compiled converter', () => {
+      converter.convert(records);
+    }),
+    b.add('array of scalars', () => {
+      PyObject.fromJS(scalars);
+    }),
+    b.cycle()
+  );
+};
@@ -0,0 +1,31 @@
+const b = require('benny');
+const { PyObject } = require('..');
+
+// JS to Python conversion of arrays of numbers
+// size is the number of elements in thousands:
+// node bench/bench.js 10,100,1000 numbers
+module.exports = function (size) {
+  const count = size * 1000;
+
+  const floats = new Array(count);
+  for (let i = 0; i < count; i++) floats[i] = i + 0.5;
+
+  // The bulk path stops at the first non-number, so this
+  // array goes through the element by element conversion
+  const generic = [null, ...floats];
+
+  return b.suite(
+    `JS to Python conversion of ${count} numbers`,
+
+    b.add('list, element by element', () => {
+      PyObject.list(generic);
+    }),
+    b.add('list, bulk', () => {
+      PyObject.list(floats);
+    }),
+    b.add('array.array(\'d\')', () => {
+      PyObject.array(floats);
+    }),
+    b.cycle()
+  );
+};
@@ -0,0 +1,29 @@
+const b = require('benny');
+const { pyval } = require('..');
+
+// Python to JS conversion of lists of records
+// size is the number of records in thousands:
+// node bench/bench.js 10,100,1000 records
+module.exports = function (size) {
+  const count = size * 1000;
+
+  const records = pyval(
+    '[{"id": i, "name": "row" + str(i), "price": i * 0.5, "active": i % 2 == 0} for i in range(n)]',
+    { n: count });
+  // Every row has its own keys, these are converted one by one
+  const heterogeneous = pyval(
+    '[{"id": i, "name": "row" + str(i), "price": i * 0.5, "k" + str(i % 4): True} for i in range(n)]',
+    { n: count });
+
+  return b.suite(
+    `Python to JS conversion of ${count} records`,
+
+    b.add('list of dicts with different keys', () => {
+      heterogeneous.toJS();
+    }),
+    b.add('list of records', () => {
+      records.toJS();
+    }),
+    b.cycle()
+  );
+};
@@ -0,0 +1,28 @@
+const b = require('benny');
+const { pymport, pyval } = require('..');
+
+// Python to JS conversion of a pandas DataFrame
+// size is the number of rows in thousands:
+// node bench/bench.js 10,100,1000 columns
+module.exports = function (size) {
+  const count = size * 1000;
+  const pd = pymport('pandas');
+  const np = pymport('numpy');
+
+  const df = pd.get('DataFrame').call(pyval(
+    '{"id": np.arange(n), "price": np.arange(n) * 0.5, "qty": np.arange(n, dtype=np.int32),' +
+    ' "active": np.arange(n) % 2 == 0}',
+    { np, n: count }));
+
+  return b.suite(
+    `Python to JS conversion of a DataFrame with ${count} rows`,
+
+    b.add('to_dict(\'records\').toJS()', () => {
+      df.get('to_dict').call('records').toJS();
+    }),
+    b.add('toColumns()', () => {
+      df.toColumns();
+    }),
+    b.cycle()
+  );
+};
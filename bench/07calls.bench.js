@@ -0,0 +1,36 @@
+const b = require('benny');
+const { pyval } = require('..');
+
+// Latency of the synchronous calls of small Python functions
+// size is the number of calls in thousands:
+// node bench/bench.js 10,100 calls
+module.exports = function (size) {
+  const calls = size * 1000;
+
+  const py_noargs = pyval('lambda: None');
+  const py_one = pyval('lambda a: a');
+  const py_three = pyval('lambda a, b, c: c');
+  const py_kwargs = pyval('lambda a, b=0, c=0: c');
+  const py_builtin = pyval('abs');
+
+  return b.suite(
+    `Synchronous calls (${calls} calls)`,
+
+    b.add('no arguments', () => {
+      for (let i = 0; i < calls; i++) py_noargs.call();
+    }),
+    b.add('one argument', () => {
+      for (let i = 0; i < calls; i++) py_one.call(i);
+    }),
+    b.add('three arguments', () => {
+      for (let i = 0; i < calls; i++) py_three.call(i, i, i);
+    }),
+    b.add('named arguments', () => {
+      for (let i = 0; i < calls; i++) py_kwargs.call(i, { b: i, c: i });
+    }),
+    b.add('builtin function', () => {
+      for (let i = 0; i < calls; i++) py_builtin.call(-i);
+    }),
+    b.cycle()
+  );
+};
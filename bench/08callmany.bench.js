@@ -0,0 +1,26 @@
+const b = require('benny');
+const { pyval } = require('..');
+
+// Per-call cost of call() vs callMany() for a small scoring function
+// size is the number of calls:
+// node bench/bench.js 10,100,1000,10000 callmany
+module.exports = function (size) {
+  const score = pyval('lambda x, y, w=1.0: (x * w + y) / 2');
+  const args = [];
+  for (let i = 0; i < size; i++) args.push([i, i + 1, { w: 0.5 }]);
+
+  return b.suite(
+    `Score ${size} argument lists`,
+
+    b.add('call()', () => {
+      for (let i = 0; i < size; i++) score.call(...args[i]).toJS();
+    }),
+    b.add('callMany()', () => {
+      score.callMany(args, { toJS: true });
+    }),
+    b.add('callManyAsync()', async () => {
+      await score.callManyAsync(args, { toJS: true });
+    }),
+    b.cycle()
+  );
+};
@@ -0,0 +1,25 @@
+const b = require('benny');
+const { PyObject, pyval } = require('..');
+
+// Python calling a JS key function in sorted()
+// size is the number of elements in thousands:
+// node bench/bench.js 1,10,100 callbacks
+module.exports = function (size) {
+  const data = pyval(`[(i * 7919) % ${size * 1000} for i in range(${size * 1000})]`);
+  const sorted = pyval('sorted');
+
+  const key_wrap = PyObject.func((v) => -v.toJS());
+  const key_value = PyObject.func((v) => -v, { convert: 'value' });
+
+  return b.suite(
+    `sorted() of ${size * 1000} elements with a JS key function`,
+
+    b.add('wrapped arguments', () => {
+      sorted.call(data, { key: key_wrap });
+    }),
+    b.add('arguments by value', () => {
+      sorted.call(data, { key: key_value });
+    }),
+    b.cycle()
+  );
+};
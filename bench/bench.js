@@ -1,6 +1,10 @@
 const fs = require('fs');
 
-const bench = fs.readdirSync(__dirname).filter((file) => file.match(/\.bench\.js$/));
+// node bench/bench.js [sizes] [filter]
+// sizes is a comma-separated list, each benchmark interprets it in its own way
+// filter is a regular expression matched against the benchmark file names
+const filter = process.argv[3] ? new RegExp(process.argv[3]) : /./;
+const bench = fs.readdirSync(__dirname).filter((file) => file.match(/\.bench\.js$/) && file.match(filter));
 
 process.env['PYTHONPATH'] = __dirname;
 
@@ -20,7 +20,16 @@
         'src/tojs.cc',
         'src/objstore.cc',
         'src/memview.cc',
-        'src/async.cc'
+        'src/memory.cc',
+        'src/release.cc',
+        'src/async.cc',
+        'src/cycles.cc',
+        'src/converter.cc',
+        'src/ndarray.cc',
+        'src/lazy.cc',
+        'src/columns.cc',
+        'src/memo.cc',
+        'src/graph.cc'
       ],
       'include_dirs': [
         "<!@(node -p \"require('node-addon-api').include\")"
@@ -1,5 +1,44 @@
 export type PyNumber = number | PyObject | null;
 
+/**
+ * Declared shape of a value converted by a compiled converter:
+ * a scalar type - `'int'`, `'float'`, `'str'`, `'bool'` or `'any'` (the generic conversion),
+ * with a trailing `?` allowing `null` and `undefined`,
+ * an array with one element for a list of elements of this schema,
+ * or an object for a dict with the declared fields.
+ */
+export type PySchema = string | [PySchema] | { [field: string]: PySchema; };
+
+/**
+ * A converter compiled from a schema by `PyObject.compileConverter()`
+ */
+export interface PyConverter {
+  /**
+   * Convert a JS value to a PyObject according to the schema
+   * @param {any} value
+   * @returns {PyObject}
+   */
+  convert(value: any): PyObject;
+
+  /**
+   * Call a Python callable with arguments converted according to the schema.
+   * As with `PyObject.call()`, a trailing plain object contains the named arguments,
+   * their values are converted according to the schema too - with a dict schema,
+   * end the arguments with `{}` to pass the last dict positionally.
+   * @param {PyObject | Function} fn a PyObject or a proxified Python function
+   * @param {...any[]} args
+   * @returns {PyObject}
+   */
+  call(fn: PyObject | ((...args: any[]) => any), ...args: any[]): PyObject;
+}
+
+/**
+ * A column returned by `PyObject.toColumns()`
+ */
+export type PyColumn = ((Int8Array | Uint8Array | Int16Array | Uint16Array | Int32Array | Uint32Array |
+  BigInt64Array | BigUint64Array | Float32Array | Float64Array) & { valid?: Uint8Array; categories?: PyColumn; }) |
+  (string | null)[];
+
 /**
  * JavaScript representation of a Python object
  */
@@ -39,6 +78,15 @@ export class PyObject implements Iterable<PyObject> {
    */
   static list: (array: any[] | PyObject) => PyObject;
 
+  /**
+   * Construct a PyObject array.array('d') from a JS array of numbers.
+   * The numbers are read in a single pass, the resulting object implements the Buffer Protocol
+   * and can be passed to numpy.frombuffer() without copying.
+   * @param {number[]} array
+   * @returns {PyObject}
+   */
+  static array: (array: number[]) => PyObject;
+
   /**
    * Construct a PyObject tuple from a JS array or a PyObject list
    * @param {any[] | PyObject} array
@@ -97,10 +145,49 @@ export class PyObject implements Iterable<PyObject> {
   /**
    * Construct a PyObject pymport.js_function from a JS function.
    * The resulting object is a Python callable.
+   * 
+   * In `async` mode, the Python calls do not wait for the JS function: the calls are queued,
+   * return `None` immediately and run in batches on the next iterations of the event loop.
+   * A full queue blocks the calling Python thread or, with `overflow: 'drop'`, drops the call.
+   * Calls from the main thread are never blocked. Exceptions thrown by the JS function
+   * become uncaught exceptions.
+   * 
+   * By default, the JS function receives its arguments as PyObjects. With `convert: 'value'`,
+   * `None`, `bool`, `int`, `float` and `str` arguments are converted to JS values and the other
+   * arguments are PyObjects. With a non-negative integer, all arguments are converted with `toJS()` to this depth,
+   * `Infinity` converts them fully.
    * @param {(...args: any[]) => any} fn arbitrary JS function
+   * @param {object} [opts] options
+   * @param {'wrap' | 'value' | number} [opts.convert] conversion of the arguments, `wrap` by default
+   * @param {'sync' | 'async'} [opts.mode] calling mode, `sync` by default
+   * @param {number} [opts.queue] maximum number of queued calls in `async` mode, 1024 by default
+   * @param {'block' | 'drop'} [opts.overflow] behavior when the queue is full, `block` by default
    * @returns {PyObject}
+   * @example
+   * const progress = PyObject.func((epoch) => console.log(+epoch), { mode: 'async', queue: 16 });
    */
-  static func: (fn: (...args: any[]) => any) => PyObject;
+  static func: (
+    fn: (...args: any[]) => any,
+    opts?: {
+      mode?: 'sync' | 'async';
+      queue?: number;
+      overflow?: 'block' | 'drop';
+      convert?: 'wrap' | 'value' | number;
+    }
+  ) => PyObject;
+
+  /**
+   * Compile a converter for values of a known shape.
+   * The converter skips the type dispatch and the discovery of the properties of
+   * the generic `fromJS()` conversion and throws a TypeError on the first value that
+   * does not match the schema. Properties that are not in the schema are ignored.
+   * @param {PySchema} schema
+   * @returns {PyConverter}
+   * @example
+   * const conv = PyObject.compileConverter({ id: 'int', name: 'str', tags: ['str'], score: 'float?' });
+   * const result = conv.call(handler, { id: 1, name: 'x', tags: [], score: null });
+   */
+  static compileConverter: (schema: PySchema) => PyConverter;
 
 
   /**
@@ -125,6 +212,11 @@ export class PyObject implements Iterable<PyObject> {
    * 
    * A Buffer becomes a bytearray.
    * 
+   * A TypedArray, a DataView or an ArrayBuffer becomes a memoryview that references directly
+   * the JS memory. A TypedArray keeps its element format (Float64Array becomes a memoryview
+   * of format 'd', Int32Array - of format 'i'...), allowing zero-copy numpy.frombuffer().
+   * The JS object is guaranteed to stay in memory for as long as Python references it.
+   * 
    * A JS function (including a native function) becomes a callable pymport.js_function
    * 
    * @param {any} value
@@ -212,6 +304,46 @@ export class PyObject implements Iterable<PyObject> {
    */
   callAsync: (...args: any[]) => Promise<PyObject>;
 
+  /**
+   * Call a callable PyObject once for every element of an array of argument lists
+   * with a single acquisition of the GIL, throws on the first Python exception.
+   * Every argument list can end with an object of named arguments.
+   * @param {any[][]} calls array of argument lists
+   * @param {object} [opts] options
+   * @param {boolean} [opts.toJS] convert the results to JS values
+   * @returns {PyObject[] | any[]}
+   * @example
+   * const results = fn.callMany([[1, 2], [3, 4, { scale: 2 }]], { toJS: true });
+   */
+  callMany: (calls: any[][], opts?: { toJS?: boolean; }) => any[];
+
+  /**
+   * Asynchronous version of `callMany()`, the calls run in a worker thread
+   * and the first Python exception rejects the whole batch
+   * @param {any[][]} calls array of argument lists
+   * @param {object} [opts] options
+   * @param {boolean} [opts.toJS] convert the results to JS values
+   * @returns {Promise<PyObject[] | any[]>}
+   */
+  callManyAsync: (calls: any[][], opts?: { toJS?: boolean; }) => Promise<any[]>;
+
+  /**
+   * Call a method of the PyObject, same as `get(name).call(...args)` but
+   * without creating an intermediate bound method object
+   * @param {string} name method name
+   * @param {...any[]} args method arguments
+   * @returns {PyObject}
+   */
+  callMethod: (name: string, ...args: any[]) => PyObject;
+
+  /**
+   * Asynchronously call a method of the PyObject, same as `get(name).callAsync(...args)`
+   * @param {string} name method name
+   * @param {...any[]} args method arguments
+   * @returns {Promise<PyObject>}
+   */
+  callMethodAsync: (name: string, ...args: any[]) => Promise<PyObject>;
+
   /**
    * Transform the PyObject to a plain JS object. Equivalent to valueOf().
    * 
@@ -233,6 +365,11 @@ export class PyObject implements Iterable<PyObject> {
    * The memory referenced by the Buffer is a copy of the Python memory. This behavior can be disabled
    * by passing { buffer: false }.
    * 
+   * Passing { buffer: 'shared' } returns Buffers that reference directly the Python memory of
+   * the writable contiguous buffers - such as numpy arrays or bytearrays - without copying.
+   * The Python object is kept alive until the Buffer is garbage-collected. All shared Buffers
+   * over the same memory use the same ArrayBuffer. Read-only buffers are still copied.
+   * 
    * A callable becomes a native (binary) function.
    * 
    * A module becomes an object.
@@ -245,12 +382,49 @@ export class PyObject implements Iterable<PyObject> {
    * Refer to the performance section of the wiki for the possible implications and especially
    * the memory overhead.
    * 
+   * Passing { lazy: true } returns Proxies for the lists, the tuples and the dictionaries with
+   * string keys. Their elements are converted when they are accessed for the first time, the
+   * length and the keys are read directly from Python. This allows to read a few elements of
+   * a large object without converting all of it. The shared references are not preserved.
+   * `Object.keys()`, `Object.entries()`, the spread operator and `JSON.stringify()` read the
+   * property descriptors and convert every element of the first level - the nested
+   * containers remain lazy. Use `.length` or `Reflect.ownKeys()` to get the keys only.
+   * 
    * @param {object} [opts] options
    * @param {number} [opts.depth] maximum recursion depth, undefined for unlimited
-   * @param {boolean} [opts.buffer] do not convert objects that implement only the Buffer protocol
+   * @param {boolean | 'shared'} [opts.buffer] false to not convert objects that implement only the
+   * Buffer protocol, 'shared' to share their memory instead of copying
+   * @param {boolean} [opts.lazy] convert the elements of the containers on first access
    * @returns {any}
    */
-  toJS: (opts?: { depth?: number; buffer?: boolean; }) => any;
+  toJS: (opts?: { depth?: number; buffer?: boolean | 'shared'; lazy?: boolean; }) => any;
+
+  /**
+   * Convert a PyObject implementing the Buffer Protocol - a numpy array, an array.array or a memoryview -
+   * to a TypedArray of the matching element type (Float64Array for 'd', BigInt64Array for 'q'...).
+   * The data is always copied to a C-contiguous array, non-contiguous views such as transposed
+   * arrays or slices with steps are packed. The `shape` and the `strides` (in elements) of the
+   * packed array are set as properties of the returned TypedArray.
+   * 
+   * @returns {TypedArray & { shape: number[]; strides: number[]; }}
+   */
+  toTypedArray: () => (Int8Array | Uint8Array | Int16Array | Uint16Array | Int32Array | Uint32Array |
+    BigInt64Array | BigUint64Array | Float32Array | Float64Array) & { shape: number[]; strides: number[]; };
+
+  /**
+   * Convert tabular data to an object of columns, { columnName: TypedArray }.
+   * 
+   * Accepts a dict of 1-D arrays implementing the Buffer Protocol (numpy arrays...) or an object
+   * implementing the DataFrame interchange protocol (`__dataframe__`) such as a pandas DataFrame.
+   * Every numeric column is copied once directly from the Python memory.
+   * 
+   * Columns with missing values (other than NaN) get a `valid` property, a Uint8Array with 0 for
+   * the missing values. Categorical columns are returned as their codes with a `categories`
+   * property. String columns are returned as arrays of strings with null for the missing values.
+   * 
+   * @returns {Record<string, PyColumn>}
+   */
+  toColumns: () => Record<string, PyColumn>;
 
   /**
    * Transform the PyObject to a plain JS object. Equivalent to toJS().
@@ -271,6 +445,39 @@ export class PyObject implements Iterable<PyObject> {
    */
   [Symbol.iterator]: () => Iterator<PyObject>;
 
+  /**
+   * Return an async iterator over the object's elements, allows to use for await.
+   * Equivalent to iterAsync() with the default options.
+   * @returns {AsyncIterator<PyObject>}
+   */
+  [Symbol.asyncIterator]: () => AsyncIterator<PyObject>;
+
+  /**
+   * Return an async iterator over the object's elements.
+   * 
+   * The Python iterator is advanced in a worker thread, batch elements at a time with a
+   * single acquisition of the GIL, so that a generator that does I/O does not block the
+   * event loop. The next batch is prefetched while the current one is consumed. No more
+   * than one batch is prefetched, a slow consumer pauses the generator.
+   * 
+   * @param {object} [opts] options
+   * @param {number} [opts.batch] number of elements per batch, 64 by default
+   * @returns {AsyncIterableIterator<PyObject>}
+   */
+  iterAsync: (opts?: { batch?: number; }) => AsyncIterableIterator<PyObject>;
+
+  /**
+   * Advance asynchronously a Python iterator by up to count elements.
+   * 
+   * This is the low-level primitive of iterAsync(), only one call can be in progress at a time.
+   * When the iterator raises an exception after producing some elements, these are returned with
+   * the exception in error.
+   * 
+   * @param {number} [count] maximum number of elements, 1 by default
+   * @returns {Promise<{ values: PyObject[]; done: boolean; error?: Error; }>}
+   */
+  nextAsync: (count?: number) => Promise<{ values: PyObject[]; done: boolean; error?: Error; }>;
+
   /**
    * Create a new array populated with the results of calling a provided function on every element in the
    * calling array.
@@ -302,6 +509,75 @@ export class PyObject implements Iterable<PyObject> {
  */
 export function pymport(name: string): PyObject;
 
+/**
+ * A deferred Python expression created by `pymport.lazy()`.
+ * 
+ * Accessing an attribute, calling it or subscripting it with `item()` records the operation
+ * without calling Python. The recorded operations are executed natively, with a single
+ * acquisition of the GIL, when the value is forced by `run()`, `toJS()` or `await`.
+ * Only the final result is wrapped in a PyObject, the result is computed only once.
+ * 
+ * `run`, `runAsync`, `toJS`, `then`, `get`, `item` and `call` are reserved names,
+ * Python attributes with these names can be accessed with `get()`.
+ * Lazy expressions can be passed as arguments and named arguments of the calls of other
+ * lazy expressions, but not inside arrays or objects.
+ */
+export type PyLazy = {
+  (...args: any[]): PyLazy;
+  [attr: string]: any;
+  /**
+   * Execute the expression
+   * @returns {PyObject}
+   */
+  run(): PyObject;
+  /**
+   * Execute the expression in a worker thread
+   * @returns {Promise<PyObject>}
+   */
+  runAsync(): Promise<PyObject>;
+  /**
+   * Execute the expression and convert the result to JS
+   * @param {object} [opts] options, same as `PyObject.toJS()`
+   * @returns {any}
+   */
+  toJS(opts?: { depth?: number; buffer?: boolean | 'shared'; }): any;
+  /**
+   * `await` executes the expression in a worker thread
+   */
+  then: Promise<PyObject>['then'];
+  /**
+   * Record an attribute access
+   * @param {string} name
+   * @returns {PyLazy}
+   */
+  get(name: string): PyLazy;
+  /**
+   * Record a subscript
+   * @param {any} key
+   * @returns {PyLazy}
+   */
+  item(key: any): PyLazy;
+  /**
+   * Record a call
+   * @param {...any[]} args
+   * @returns {PyLazy}
+   */
+  call(...args: any[]): PyLazy;
+};
+
+export namespace pymport {
+  /**
+   * Create a deferred expression graph rooted at a PyObject
+   * 
+   * @param {PyObject} v root object, usually a module
+   * @returns {PyLazy}
+   * @example
+   * const np = pymport.lazy(pymport('numpy'));
+   * const a = np.matmul(np.arange(6).reshape([2, 3]).T, np.ones([2, 2])).run();
+   */
+  function lazy(v: PyObject): PyLazy;
+}
+
 /**
  * Create a proxified version of a PyObject that works like a native Python object.
  * All values returned by its methods will also be proxified.
@@ -357,6 +633,143 @@ declare const version: {
   readonly pythonRuntime: null | string;
 };
 
+/**
+ * Enable or disable the background release mode.
+ * 
+ * By default, when the V8 GC collects a PyObject, the Python reference is released
+ * synchronously in the V8 thread. This requires obtaining the GIL and the Python destructors
+ * run on the event loop - which can be expensive when a large number of objects is collected
+ * at once or when releasing an object frees a large object graph.
+ * 
+ * In background release mode, the references are queued and released in batches by a dedicated
+ * Python thread. The Python objects are freed with a slight delay.
+ * 
+ * @param {boolean} enable
+ */
+export function backgroundRelease(enable: boolean): void;
+
+/**
+ * Retrieve the background release statistics
+ * @returns {object}
+ */
+export function releaseStats(): {
+  readonly enabled: boolean;
+  /**
+   * Number of references waiting to be released
+   */
+  readonly depth: number;
+  /**
+   * Total number of references released in the background
+   */
+  readonly released: number;
+  /**
+   * Number of batches, each one is a single GIL acquisition
+   */
+  readonly batches: number;
+  /**
+   * Duration of the last batch in ms, including waiting for the GIL
+   */
+  readonly lastDrainTime: number;
+  /**
+   * Duration of the slowest batch in ms, including waiting for the GIL
+   */
+  readonly maxDrainTime: number;
+};
+
+/**
+ * Select how the memory used by the Python objects is reported to the V8 GC.
+ * 
+ * In `estimate` mode (the default), every PyObject reports its own size: the size of the buffer for
+ * objects implementing the Buffer protocol (bytes, numpy arrays...) or `__sizeof__` for the others.
+ * The elements of the containers are separate objects. The size of lists, dictionaries, sets and
+ * bytearrays is refreshed when they are accessed from JS.
+ * 
+ * In `tracemalloc` mode, the whole Python heap, as measured by `tracemalloc`, is reported. This mode
+ * starts `tracemalloc` if it is not already running, which slows down all Python memory allocations.
+ * 
+ * @param {'estimate' | 'tracemalloc'} mode
+ */
+export function memoryAccounting(mode: 'estimate' | 'tracemalloc'): void;
+
+/**
+ * Collect the reference cycles between JS and Python.
+ * 
+ * A JS function passed to Python holds a strong reference to the function. If this function
+ * also references (through its closure) a PyObject that leads back to it, neither of the two
+ * garbage collectors can free the cycle.
+ * 
+ * This function finds the JS functions that are referenced by Python only through objects that
+ * are themselves kept alive by JS, and moves their references to the V8 heap, allowing V8 to
+ * free the whole cycle. It walks the whole Python heap and should be called periodically by
+ * long-running applications that pass callbacks to Python.
+ * 
+ * Any use from JS of the objects that lead to such a function - calling a method or passing
+ * it to Python - restores the strong references, so Python cannot store the function somewhere
+ * and then call it after it has been freed. The next call of `collectCycles()` downgrades them again.
+ * The Python finalizers (`__del__`) and `gc.get_referrers()` are the only exceptions.
+ * 
+ * @returns {{ weakened: number; strengthened: number; }} number of references that were downgraded
+ * to weak references and number of weak references that were restored
+ */
+export function collectCycles(): { weakened: number; strengthened: number; };
+
+/**
+ * Enable or disable the memoization of the conversions of the immutable objects.
+ * 
+ * When enabled, `toJS()` of a tuple or a frozenset that contains only `None`, `bool`, `int`,
+ * `float`, `str` and other such tuples and frozensets returns the same frozen array as long as
+ * it has not been garbage-collected by V8. The Python object is kept alive by the cache.
+ * 
+ * This changes the result of `toJS()`: these arrays are frozen and shared by all the
+ * conversions, modifying them throws in strict mode and is ignored otherwise. The immutable
+ * tuples inside mutable objects are cached too.
+ * 
+ * Disabling the cache drops all its entries.
+ * 
+ * @param {boolean} enable
+ */
+export function memoCache(enable: boolean): void;
+
+/**
+ * Retrieve the memo cache statistics
+ * @returns {object}
+ */
+export function memoStats(): {
+  readonly enabled: boolean;
+  /**
+   * Number of cached conversions
+   */
+  readonly size: number;
+  /**
+   * Number of conversions returned from the cache
+   */
+  readonly hits: number;
+  /**
+   * Number of conversions added to the cache
+   */
+  readonly misses: number;
+};
+
+/**
+ * Retrieve the queue statistics of a JS function created with `PyObject.func()` in `async` mode
+ * @param {PyObject} fn pymport.js_function in `async` mode
+ * @returns {object}
+ */
+export function asyncCallStats(fn: PyObject): {
+  /**
+   * Maximum number of queued calls
+   */
+  readonly limit: number;
+  /**
+   * Number of calls waiting to run
+   */
+  readonly queued: number;
+  /**
+   * Number of calls dropped because the queue was full or the environment was shutting down
+   */
+  readonly dropped: number;
+};
+
 /**
  * Errors thrown from Python have a `pythonTrace` property that contains the Python traceback
  */
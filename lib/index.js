@@ -40,8 +40,80 @@ module.exports.PyObject.prototype[Symbol.iterator] = function () {
   };
 };
 
+// The async iterator advances the Python iterator in a worker thread,
+// batch elements at a time, while the next batch is being fetched,
+// the consumer receives the elements of the previous one
+// At most one batch is prefetched - a slow consumer stops the iteration
+module.exports.PyObject.prototype.iterAsync = function (opts) {
+  const batch = (opts && opts.batch) || 64;
+  let it = this;
+  const py_next = this.get('__next__');
+  if (py_next === undefined || !py_next.callable) {
+    const py_iter = this.get('__iter__');
+    if (py_iter === undefined || !py_iter.callable)
+      throw new TypeError(`PyObject type ${this.type} is not iterable`);
+    it = py_iter.call();
+  }
+
+  let buffer = [];
+  let pos = 0;
+  let done = false;
+  let error;
+  let pending;
+  const fetch = () => {
+    pending = it.nextAsync(batch);
+    // The consumer may never ask for it
+    pending.catch(() => undefined);
+  };
+  fetch();
+
+  const pull = async () => {
+    while (pos >= buffer.length) {
+      if (error) {
+        const e = error;
+        error = undefined;
+        throw e;
+      }
+      if (done) return { done: true, value: undefined };
+      const r = await pending;
+      buffer = r.values;
+      pos = 0;
+      done = r.done;
+      error = r.error;
+      if (!done) fetch();
+    }
+    return { done: false, value: buffer[pos++] };
+  };
+  // Concurrent next() calls are chained, only one fetch can be in flight
+  let queue = Promise.resolve();
+
+  return {
+    next() {
+      const r = queue.then(pull);
+      queue = r.catch(() => undefined);
+      return r;
+    },
+    async return(value) {
+      done = true;
+      buffer = [];
+      return { done: true, value };
+    },
+    [Symbol.asyncIterator]() {
+      return this;
+    }
+  };
+};
+
+module.exports.PyObject.prototype[Symbol.asyncIterator] = function () {
+  return this.iterAsync();
+};
+
 const proxyStore = new WeakMap();
 
+// Internal, used by the proxy
+const { getMember } = module.exports;
+delete module.exports.getMember;
+
 // If one of the arguments is a function,
 // replace it with a wrapper that proxifies the arguments
 function proxifyCallbackArguments(args) {
@@ -83,6 +155,27 @@ function proxify(v, name) {
   return v;
 }
 
+// A method is called as its function with the object as the first argument,
+// exactly as a bound method does, without creating the bound method
+// The bound method is created only when it is needed as a PyObject
+function proxifyMethod(fn, name, owner) {
+  const method = (...args) => {
+    proxifyCallbackArguments(args);
+    const result = fn.call(owner, ...args);
+    return proxify(result);
+  };
+  Object.defineProperty(method, 'name', { value: name, writable: false });
+  let bound;
+  Object.defineProperty(method, '__PyObject__', {
+    get: () => {
+      if (bound === undefined) bound = fn.get('__get__').call(owner);
+      return bound;
+    },
+    enumerable: false
+  });
+  return new Proxy(method, proxy);
+}
+
 function proxyIterator() {
   const it = this[Symbol.iterator]();
 
@@ -139,7 +232,8 @@ const proxy = {
 
     let r;
     // attr is the Python attribute of the underlying Python object
-    const attr = target.get(prop);
+    // or [function] if it is a method
+    const attr = typeof prop === 'string' ? getMember(target, prop) : undefined;
     if (attr === undefined) {
       if (target[prop] !== undefined) {
         // there is no underlying Python attribute of this name
@@ -162,6 +256,9 @@ const proxy = {
         // but there is a Proxy property (this is probably the name)
         r = proxyProp;
       }
+    } else if (Array.isArray(attr)) {
+      // Create a proxified method that does not need the bound method
+      r = proxifyMethod(attr[0], prop, target);
     } else {
       // Create a proxified object for the Python attribute
       r = proxify(attr, prop);
@@ -207,4 +304,126 @@ module.exports.PyObject.prototype.map = function (cb, thisArg) {
 
 module.exports.proxify = proxify;
 
+// Deferred expression graphs
+// A lazy expression records the get/item/call operations and executes them natively,
+// under a single GIL acquisition, when its value is forced by run(), toJS() or await
+// The graph format is described in src/graph.cc
+const { runGraph, runGraphAsync } = module.exports;
+delete module.exports.runGraph;
+delete module.exports.runGraphAsync;
+
+const lazyNode = Symbol('pymport.lazyNode');
+
+function isLazy(v) {
+  return typeof v === 'function' && v[lazyNode] !== undefined;
+}
+
+// Same rules as the named arguments of call()
+function isKwargs(v) {
+  return typeof v === 'object' && v !== null && !Array.isArray(v) &&
+    !(v instanceof module.exports.PyObject) && !ArrayBuffer.isView(v);
+}
+
+function lazyExpr(node) {
+  const target = function () { };
+  target[lazyNode] = node;
+  return new Proxy(target, lazyHandler);
+}
+
+function lazyCall(node, args) {
+  let kwargs;
+  if (args.length > 0 && isKwargs(args[args.length - 1])) kwargs = args.pop();
+  else if (args.length > 1 && args[args.length - 1] === undefined) args.pop();
+  return lazyExpr({ op: 3, obj: node, args, kwargs });
+}
+
+// Serializes the operations that lead to node, the nodes that have already been forced are values
+function lazyGraph(target) {
+  const nodes = [];
+  const index = new Map();
+  const visit = (node) => {
+    let idx = index.get(node);
+    if (idx !== undefined) return idx;
+    let n;
+    if (node.result !== undefined) {
+      n = [0, node.result];
+    } else if (node.op === 1) {
+      n = [1, visit(node.obj), node.name];
+    } else if (node.op === 2) {
+      n = isLazy(node.key) ? [2, visit(node.obj), null, visit(node.key[lazyNode])] : [2, visit(node.obj), node.key, -1];
+    } else {
+      const fn = visit(node.obj);
+      const args = [];
+      const argNodes = [];
+      const push = (v) => {
+        args.push(isLazy(v) ? null : v);
+        argNodes.push(isLazy(v) ? visit(v[lazyNode]) : -1);
+      };
+      node.args.forEach(push);
+      let kwnames;
+      if (node.kwargs) {
+        kwnames = [];
+        for (const name in node.kwargs) {
+          kwnames.push(name);
+          push(node.kwargs[name]);
+        }
+      }
+      n = [3, fn, args, argNodes, kwnames];
+    }
+    idx = nodes.length;
+    nodes.push(n);
+    index.set(node, idx);
+    return idx;
+  };
+  visit(target);
+  return nodes;
+}
+
+// The result of an expression is computed only once
+function lazyRun(node) {
+  if (node.result === undefined) node.result = runGraph(lazyGraph(node));
+  return node.result;
+}
+
+function lazyRunAsync(node) {
+  if (node.result !== undefined) return Promise.resolve(node.result);
+  return runGraphAsync(lazyGraph(node)).then((r) => {
+    node.result = r;
+    return r;
+  });
+}
+
+const lazyHandler = {
+  get(target, prop) {
+    const node = target[lazyNode];
+    if (typeof prop === 'symbol') return prop === lazyNode ? node : undefined;
+    switch (prop) {
+      case 'run':
+        return () => lazyRun(node);
+      case 'runAsync':
+        return () => lazyRunAsync(node);
+      case 'toJS':
+        return (opts) => lazyRun(node).toJS(opts);
+      case 'then':
+        return (resolve, reject) => lazyRunAsync(node).then(resolve, reject);
+      case 'get':
+        return (name) => lazyExpr({ op: 1, obj: node, name });
+      case 'item':
+        return (key) => lazyExpr({ op: 2, obj: node, key });
+      case 'call':
+        return (...args) => lazyCall(node, args);
+    }
+    return lazyExpr({ op: 1, obj: node, name: prop });
+  },
+  apply(target, thisArg, args) {
+    return lazyCall(target[lazyNode], args);
+  }
+};
+
+module.exports.pymport.lazy = function (v) {
+  if (v !== null && v !== undefined && v.__PyObject__ instanceof module.exports.PyObject) v = v.__PyObject__;
+  if (!(v instanceof module.exports.PyObject)) throw new TypeError('Argument must be a PyObject');
+  return lazyExpr({ result: v });
+};
+
 exports = module.exports;
@@ -5,3 +5,10 @@ export const proxify = cjs.proxify;
 export const PyObject = cjs.PyObject;
 export const pyval = cjs.pyval;
 export const version = cjs.version;
+export const backgroundRelease = cjs.backgroundRelease;
+export const releaseStats = cjs.releaseStats;
+export const memoryAccounting = cjs.memoryAccounting;
+export const collectCycles = cjs.collectCycles;
+export const memoCache = cjs.memoCache;
+export const memoStats = cjs.memoStats;
+export const asyncCallStats = cjs.asyncCallStats;
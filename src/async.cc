@@ -1,4 +1,5 @@
 #include <functional>
+#include <vector>
 #include "pymport.h"
 #include "pystackobject.h"
 #include "values.h"
@@ -70,4 +71,229 @@ Value PyObjectWrap::CallAsync(const CallbackInfo &info) {
   return deferred.Promise();
 }
 
+// Asynchronous method call from JavaScript to Python
+Value PyObjectWrap::CallMethodAsync(const CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  PyGILGuard pyGilGuard;
+  PyStrongRef name(_MethodName(env, info[0]));
+  PyStrongRef obj(self);
+  // The arguments point into themselves and cannot be moved
+  auto call = std::make_shared<VectorcallArgs>();
+  _FromJS_Vectorcall(info, 1, *call);
+  PyCallExecutor *fn = new PyCallExecutor(
+    [obj = std::move(obj), name = std::move(name), call]() { return _VectorcallMethod(obj, name, *call); });
+  auto deferred = Promise::Deferred::New(env);
+  PympWorker *worker = new PympWorker(env, fn, deferred);
+  worker->Queue();
+  return deferred.Promise();
+}
+
+// Asynchronous execution of an expression graph (graph.cc), the JS values are converted
+// on the main thread and the graph runs in a worker thread
+Value PyObjectWrap::RunGraphAsync(const CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  Array nodes = NAPI_ARG_ARRAY(0);
+  PyGILGuard pyGilGuard;
+  auto graph = _CompileGraph(env, nodes);
+  PyCallExecutor *fn = new PyCallExecutor([graph]() { return _RunGraph(*graph); });
+  auto deferred = Promise::Deferred::New(env);
+  PympWorker *worker = new PympWorker(env, fn, deferred);
+  worker->Queue();
+  return deferred.Promise();
+}
+
+// Calls a callable for every argument list with a single GIL acquisition
+class PympManyWorker : public AsyncWorker {
+    public:
+  PympManyWorker(Napi::Env, PyCallManyExecutor *, size_t, bool, Promise::Deferred &);
+  virtual ~PympManyWorker();
+
+  virtual void Execute() override;
+  virtual void OnOK() override;
+  virtual void OnError(const Napi::Error &) override;
+
+    private:
+  PyCallManyExecutor *executor;
+  size_t count;
+  bool tojs;
+  std::vector<PyStrongRef> results;
+  Promise::Deferred promise;
+  PythonException *err;
+};
+
+inline PympManyWorker::PympManyWorker(
+  Napi::Env env, PyCallManyExecutor *executor, size_t count, bool tojs, Promise::Deferred &promise)
+  : AsyncWorker(env, "pymport"), executor(executor), count(count), tojs(tojs), promise(promise), err(nullptr) {
+}
+
+inline PympManyWorker::~PympManyWorker() {
+  ASSERT(results.empty());
+}
+
+void PympManyWorker::Execute() {
+  // This runs in one of the worker threads in the libuv pool
+  PyGILGuard pyGilGuard;
+  results.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    PyStrongRef r = (*executor)(i);
+    if (*r == nullptr) {
+      // The first exception rejects the whole batch
+      err = new PythonException(LINEINFO);
+      break;
+    }
+    results.push_back(std::move(r));
+  }
+  // The executor contains PyStrongRefs and must be deleted with the GIL held
+  delete executor;
+}
+
+void PympManyWorker::OnOK() {
+  Napi::Env env = Env();
+  PyGILGuard pyGILGuard;
+  HandleScope scope(env);
+  if (err == nullptr) {
+    Array r = Array::New(env, results.size());
+    for (size_t i = 0; i < results.size(); i++) {
+      r.Set(
+        static_cast<uint32_t>(i),
+        tojs ? PyObjectWrap::ToJS(env, results[i], {-1, true, false}) : PyObjectWrap::New(env, std::move(results[i])));
+    }
+    promise.Resolve(r);
+  } else {
+    promise.Reject(err->ToJS(env).Value());
+    delete err;
+  }
+  results.clear();
+}
+
+void PympManyWorker::OnError(const Napi::Error &error) {
+  Error::Fatal("pymport async worker onError", "failed calling Python");
+}
+
+// Asynchronous version of callMany, the argument lists are converted on the main thread
+Value PyObjectWrap::CallManyAsync(const CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  Array calls = NAPI_ARG_ARRAY(0);
+  Object opts = NAPI_OPT_ARG_OBJECT(1);
+  bool tojs = !opts.IsEmpty() && opts.Has("toJS") && opts.Get("toJS").ToBoolean().Value();
+
+  PyGILGuard pyGilGuard;
+  if (!PyCallable_Check(*self)) { throw Napi::TypeError::New(env, "Value not callable"); }
+  uint32_t len = calls.Length();
+  // The arguments point into themselves and cannot be moved
+  auto args = std::make_shared<std::vector<std::unique_ptr<VectorcallArgs>>>();
+  args->reserve(len);
+  for (uint32_t i = 0; i < len; i++) {
+    HandleScope scope(env);
+    Napi::Value el = calls.Get(i);
+    if (!el.IsArray()) throw TypeError::New(env, "Arguments must be arrays");
+    args->push_back(std::make_unique<VectorcallArgs>());
+    _FromJS_Vectorcall(el.As<Array>(), *args->back());
+  }
+
+  PyCallManyExecutor *fn = new PyCallManyExecutor([fn = PyStrongRef(self), args](size_t i) {
+    VectorcallArgs &call = *(*args)[i];
+    return PyStrongRef(
+      PyObject_Vectorcall(*fn, call.args + 1, call.nargs | PY_VECTORCALL_ARGUMENTS_OFFSET, *call.kwnames));
+  });
+  auto deferred = Promise::Deferred::New(env);
+  PympManyWorker *worker = new PympManyWorker(env, fn, len, tojs, deferred);
+  worker->Queue();
+  return deferred.Promise();
+}
+
+// Advances an iterator by up to count elements with a single GIL acquisition
+class PympIterWorker : public AsyncWorker {
+    public:
+  PympIterWorker(Napi::Env, PyStrongRef &&, size_t, Promise::Deferred &);
+  virtual ~PympIterWorker();
+
+  virtual void Execute() override;
+  virtual void OnOK() override;
+  virtual void OnError(const Napi::Error &) override;
+
+    private:
+  PyStrongRef iter;
+  size_t count;
+  std::vector<PyStrongRef> items;
+  bool done;
+  Promise::Deferred promise;
+  PythonException *err;
+};
+
+inline PympIterWorker::PympIterWorker(Napi::Env env, PyStrongRef &&iter, size_t count, Promise::Deferred &promise)
+  : AsyncWorker(env, "pymport"), iter(std::move(iter)), count(count), done(false), promise(promise), err(nullptr) {
+}
+
+inline PympIterWorker::~PympIterWorker() {
+  ASSERT(*iter == nullptr);
+  ASSERT(items.empty());
+}
+
+void PympIterWorker::Execute() {
+  // This runs in one of the worker threads in the libuv pool
+  PyGILGuard pyGilGuard;
+  items.reserve(count);
+  while (items.size() < count) {
+    PyStrongRef item = PyIter_Next(*iter);
+    if (*item == nullptr) {
+      // The elements before the exception are still delivered
+      if (PyErr_Occurred()) err = new PythonException(LINEINFO);
+      done = true;
+      break;
+    }
+    items.push_back(std::move(item));
+  }
+}
+
+void PympIterWorker::OnOK() {
+  Napi::Env env = Env();
+  PyGILGuard pyGILGuard;
+  HandleScope scope(env);
+  iter = nullptr;
+
+  if (err != nullptr && items.empty()) {
+    promise.Reject(err->ToJS(env).Value());
+    delete err;
+    return;
+  }
+
+  Napi::Array values = Napi::Array::New(env, items.size());
+  for (size_t i = 0; i < items.size(); i++) values.Set(i, PyObjectWrap::New(env, std::move(items[i])));
+  items.clear();
+  Object r = Object::New(env);
+  r.Set("values", values);
+  r.Set("done", Boolean::New(env, done));
+  if (err != nullptr) {
+    r.Set("error", err->ToJS(env).Value());
+    delete err;
+  }
+  promise.Resolve(r);
+}
+
+void PympIterWorker::OnError(const Napi::Error &error) {
+  Error::Fatal("pymport async worker onError", "failed iterating Python");
+}
+
+// Asynchronous iteration, returns the next count elements of the iterator (this)
+// Only one call can be in flight at a time, the JS async iterator (lib/index.js)
+// takes care of this
+Value PyObjectWrap::NextAsync(const CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  PyGILGuard pyGilGuard;
+
+  if (!PyIter_Check(*self)) throw TypeError::New(env, "PyObject is not an iterator");
+  size_t count = 1;
+  if (info.Length() > 0 && !info[0].IsUndefined()) {
+    int64_t n = info[0].ToNumber().Int64Value();
+    if (n < 1) throw RangeError::New(env, "The number of elements must be positive");
+    count = static_cast<size_t>(n);
+  }
+
+  auto deferred = Promise::Deferred::New(env);
+  PympIterWorker *worker = new PympIterWorker(env, PyStrongRef(self), count, deferred);
+  worker->Queue();
+  return deferred.Promise();
+}
+
 } // namespace pymport
@@ -1,23 +1,17 @@
 
 #include <vector>
 #include <condition_variable>
+#include <cmath>
 
 #include "pymport.h"
+#include "structmember.h"
 #include "pystackobject.h"
 #include "values.h"
 
 using namespace Napi;
 using namespace pymport;
 
-// A JSCall_Trampoline is a Python callable object that contains a JS function
-// This callable type cannot be constructed from Python and is normally not visible
-// except when inspecting a function object passed from JS
-// It has a PyType_Slot descriptor that can be found below
-typedef struct {
-  PyObject_HEAD;
-  FunctionReference *js_fn;
-  ThreadSafeFunction *js_tsfn;
-} JSCall_Trampoline;
+static PyObject *JSCall_Trampoline_Vectorcall(PyObject *, PyObject *const *, size_t, PyObject *);
 
 // This function is called from a Python context and can run in every thread
 static PyObject *JSCall_Trampoline_Constructor(PyTypeObject *type, PyObject *args, PyObject *kw) {
@@ -27,32 +21,80 @@ static PyObject *JSCall_Trampoline_Constructor(PyTypeObject *type, PyObject *arg
   // Make sure we don't segfault if someone manages to call us from Python
   me->js_fn = nullptr;
   me->js_tsfn = nullptr;
+  me->weak = false;
+  me->async = nullptr;
+  me->args_mode = JSCALL_ARGS_WRAP;
+  me->args_depth = -1;
+  me->vectorcall = JSCall_Trampoline_Vectorcall;
   return reinterpret_cast<PyObject *>(me);
 }
 
+// Converts an argument according to the policy of the function
+static inline Napi::Value JSCall_Argument(Napi::Env env, JSCall_Trampoline *fn, PyObject *v) {
+  switch (fn->args_mode) {
+    case JSCALL_ARGS_VALUE:
+      if (v == Py_None || PyBool_Check(v) || PyLong_Check(v) || PyFloat_Check(v) || PyUnicode_Check(v))
+        return PyObjectWrap::ToJS(env, v, {1, true, false});
+      break;
+    case JSCALL_ARGS_TOJS:
+      return PyObjectWrap::ToJS(env, v, {fn->args_depth, true, false});
+    case JSCALL_ARGS_WRAP:
+      break;
+  }
+  return PyObjectWrap::New(env, PyStrongRef(PyWeakRef(v)));
+}
+
+// A trampoline downgraded by the cycle collector is upgraded back to a strong reference
+// every time it is used - it may have escaped to a Python root since the collection
+// Must be called on the V8 main thread
+static inline void JSCall_Strengthen(JSCall_Trampoline *fn) {
+  if (fn->weak && !fn->js_fn->Value().IsEmpty()) {
+    VERBOSE_PYOBJ(CALL, reinterpret_cast<PyObject *>(fn), "jscall_trampoline strengthen");
+    fn->js_fn->Ref();
+    fn->weak = false;
+  }
+}
+
 // A Python wrapper around a JS function
 // It returns an owned reference as per the Python calling convention
 // Called from Python context but always on the V8 main thread
-static PyObject *CallJSWithPythonArgs(JSCall_Trampoline *fn, PyObject *args, PyObject *kw) {
+// The arguments are either in the vectorcall convention (args, nargs, kwnames)
+// or positional arguments and a dictionary of named arguments (kw)
+// callback is set when it is called from the event loop and not from JS
+static PyObject *CallJSWithPythonArgs(
+  JSCall_Trampoline *fn,
+  PyObject *const *args,
+  size_t nargs,
+  PyObject *kwnames,
+  PyObject *kw,
+  bool callback = false) {
   Napi::Env env = fn->js_fn->Env();
   std::vector<napi_value> js_args;
+  js_args.reserve(nargs + 1);
+
+  // The JS function has been downgraded by the cycle collector and then collected by V8
+  Function js_fn = fn->js_fn->Value();
+  if (js_fn.IsEmpty()) throw Error::New(env, "JS function has been garbage-collected");
+  JSCall_Strengthen(fn);
 
   // Positional arguments
-  size_t len = PyTuple_Size(args);
-  for (size_t i = 0; i < len; i++) {
-    PyWeakRef v = PyTuple_GetItem(args, i);
-    PyObjectWrap::EXCEPTION_CHECK(env, v);
-    js_args.push_back(PyObjectWrap::New(env, PyStrongRef(v)));
-  }
+  for (size_t i = 0; i < nargs; i++) js_args.push_back(JSCall_Argument(env, fn, args[i]));
 
   // Named arguments -> placed in a object as a last argument
-  if (kw != nullptr) {
+  if (kwnames != nullptr && PyTuple_GET_SIZE(kwnames) > 0) {
+    auto js_kwargs = Object::New(env);
+    for (Py_ssize_t i = 0; i < PyTuple_GET_SIZE(kwnames); i++) {
+      auto jsKey = PyObjectWrap::ToJS(env, PyTuple_GET_ITEM(kwnames, i), {1, true, false});
+      js_kwargs.Set(jsKey, JSCall_Argument(env, fn, args[nargs + i]));
+    }
+    js_args.push_back(js_kwargs);
+  } else if (kw != nullptr) {
     auto js_kwargs = Object::New(env);
     PyWeakRef key = nullptr, value = nullptr;
     Py_ssize_t pos = 0;
     while (PyDict_Next(kw, &pos, &key, &value)) {
-      auto jsKey = PyObjectWrap::ToJS(env, key, {1, true});
-      js_kwargs.Set(jsKey, PyObjectWrap::New(env, PyStrongRef(value)));
+      auto jsKey = PyObjectWrap::ToJS(env, key, {1, true, false});
+      js_kwargs.Set(jsKey, JSCall_Argument(env, fn, *value));
     }
     js_args.push_back(js_kwargs);
   }
@@ -61,7 +103,7 @@ static PyObject *CallJSWithPythonArgs(JSCall_Trampoline *fn, PyObject *args, PyO
   Value js_ret;
   PyThreadState *python_state = PyEval_SaveThread();
   try {
-    js_ret = fn->js_fn->Call(js_args);
+    js_ret = callback ? js_fn.MakeCallback(env.Undefined(), js_args) : js_fn.Call(js_args);
   } catch (const Error &err) {
     PyEval_RestoreThread(python_state);
     throw err;
@@ -73,6 +115,134 @@ static PyObject *CallJSWithPythonArgs(JSCall_Trampoline *fn, PyObject *args, PyO
   return ret.gift();
 }
 
+static PyObject *CallJSWithPythonArgs(JSCall_Trampoline *fn, PyObject *args, PyObject *kw, bool callback = false) {
+  return CallJSWithPythonArgs(fn, &PyTuple_GET_ITEM(args, 0), PyTuple_GET_SIZE(args), nullptr, kw, callback);
+}
+
+// Fire-and-forget call from Python to JavaScript, returns None
+// Called from Python context in any thread, the call is queued for the V8 main thread
+// A full queue blocks the calling thread or drops the call, the V8 main thread never blocks
+static PyObject *JSCall_Trampoline_Enqueue(JSCall_Trampoline *me, PyObject *args, PyObject *kw) {
+  auto context = me->js_fn->Env().GetInstanceData<EnvContext>();
+  bool main = std::this_thread::get_id() == context->v8_main;
+
+  std::unique_lock<std::mutex> lock(context->js_async.lock);
+  // The environment is shutting down, nothing will run the queue
+  if (context->js_async.closed) {
+    me->async->dropped++;
+    Py_RETURN_NONE;
+  }
+  while (me->async->queued >= me->async->limit) {
+    if (me->async->drop) {
+      me->async->dropped++;
+      Py_RETURN_NONE;
+    }
+    // The V8 main thread cannot wait for itself
+    if (main) break;
+    // Release the GIL while waiting, the lock must be reacquired after the GIL
+    PyThreadState *python_state = PyEval_SaveThread();
+    context->js_async.space.wait(
+      lock, [me, context] { return me->async->queued < me->async->limit || context->js_async.closed; });
+    lock.unlock();
+    PyEval_RestoreThread(python_state);
+    lock.lock();
+    if (context->js_async.closed) {
+      me->async->dropped++;
+      Py_RETURN_NONE;
+    }
+  }
+
+  Py_INCREF(me);
+  Py_INCREF(args);
+  Py_XINCREF(kw);
+  context->js_async.calls.push_back({reinterpret_cast<PyObject *>(me), args, kw});
+  me->async->queued++;
+  lock.unlock();
+  // Multiple sends before the event loop wakes up are coalesced into one batch
+  uv_async_send(context->js_async.handle);
+  Py_RETURN_NONE;
+}
+
+// Runs the queued fire-and-forget calls on the V8 main thread with a single GIL acquisition
+// Exceptions thrown by the JS functions are uncaught exceptions
+void PyObjectWrap::RunJSAsyncCalls(uv_async_t *async) {
+  auto context = reinterpret_cast<EnvContext *>(async->data);
+  std::vector<EnvContext::JSAsyncCall> batch;
+  {
+    std::lock_guard<std::mutex> lock(context->js_async.lock);
+    batch.swap(context->js_async.calls);
+  }
+  if (batch.empty()) return;
+  VERBOSE(CALL, "RunJSAsyncCalls, batch length %d\n", static_cast<int>(batch.size()));
+
+  Napi::Env env(context->js_async.env);
+  PyGILGuard pyGilGuard;
+  for (auto const &call : batch) {
+    HandleScope scope(env);
+    try {
+      PyObject *r = CallJSWithPythonArgs(reinterpret_cast<JSCall_Trampoline *>(call.fn), call.args, call.kw, true);
+      Py_XDECREF(r);
+    } catch (const Error &err) { napi_fatal_exception(env, err.Value()); }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(context->js_async.lock);
+    for (auto const &call : batch) reinterpret_cast<JSCall_Trampoline *>(call.fn)->async->queued--;
+  }
+  context->js_async.space.notify_all();
+
+  for (auto const &call : batch) {
+    Py_DECREF(call.fn);
+    Py_DECREF(call.args);
+    Py_XDECREF(call.kw);
+  }
+}
+
+// Called by the environment cleanup hook with the GIL held
+// The queued calls are dropped and the blocked Python threads are released
+void PyObjectWrap::CloseJSAsyncCalls(EnvContext *context) {
+  std::vector<EnvContext::JSAsyncCall> batch;
+  {
+    std::lock_guard<std::mutex> lock(context->js_async.lock);
+    context->js_async.closed = true;
+    batch.swap(context->js_async.calls);
+    for (auto const &call : batch) {
+      auto async = reinterpret_cast<JSCall_Trampoline *>(call.fn)->async;
+      async->queued--;
+      async->dropped++;
+    }
+  }
+  context->js_async.space.notify_all();
+  VERBOSE(INIT, "Dropping %d fire-and-forget calls\n", static_cast<int>(batch.size()));
+
+  for (auto const &call : batch) {
+    Py_DECREF(call.fn);
+    Py_DECREF(call.args);
+    Py_XDECREF(call.kw);
+  }
+}
+
+// Statistics of a fire-and-forget JS function
+Value PyObjectWrap::AsyncCallStats(const CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  PyGILGuard pyGilGuard;
+  auto context = env.GetInstanceData<EnvContext>();
+
+  Object fn = NAPI_ARG_PYOBJECT(0);
+  PyObjectWrap *wrap = Unwrap(fn);
+  if (Py_TYPE(*wrap->self) != reinterpret_cast<PyTypeObject *>(*JSCall_Trampoline_Type) ||
+      reinterpret_cast<JSCall_Trampoline *>(*wrap->self)->async == nullptr)
+    throw TypeError::New(env, "Argument must be an async pymport.js_function");
+  JSCall_Async *async = reinterpret_cast<JSCall_Trampoline *>(*wrap->self)->async;
+
+  std::lock_guard<std::mutex> lock(context->js_async.lock);
+  Object r = Object::New(env);
+  r.Set("limit", Number::New(env, static_cast<double>(async->limit)));
+  r.Set("queued", Number::New(env, static_cast<double>(async->queued)));
+  r.Set("dropped", Number::New(env, static_cast<double>(async->dropped)));
+  return r;
+}
+
 // Synchronous call from Python to JavaScript
 // Called from Python context, if called on a worker thread blocks and waits for the main thread
 static PyObject *JSCall_Trampoline_Call(PyObject *self, PyObject *args, PyObject *kw) {
@@ -84,6 +254,7 @@ static PyObject *JSCall_Trampoline_Call(PyObject *self, PyObject *args, PyObject
       "Called an empty JS function, don't manually construct objects of pymport.js_function type\n");
     return nullptr;
   }
+  if (me->async != nullptr) return JSCall_Trampoline_Enqueue(me, args, kw);
   Napi::Env env = me->js_fn->Env();
 
   bool async = false;
@@ -131,17 +302,67 @@ static PyObject *JSCall_Trampoline_Call(PyObject *self, PyObject *args, PyObject
   }
 }
 
+// Vectorcall from Python to JavaScript
+// Only the synchronous calls on the V8 main thread avoid the construction of the argument tuple,
+// all other calls go through JSCall_Trampoline_Call
+static PyObject *JSCall_Trampoline_Vectorcall(PyObject *self, PyObject *const *args, size_t nargsf, PyObject *kwnames) {
+  JSCall_Trampoline *me = reinterpret_cast<JSCall_Trampoline *>(self);
+  size_t nargs = PyVectorcall_NARGS(nargsf);
+
+  if (me->js_fn == nullptr || me->async != nullptr ||
+      std::this_thread::get_id() != me->js_fn->Env().GetInstanceData<EnvContext>()->v8_main) {
+    PyStrongRef tuple = PyTuple_New(nargs);
+    if (tuple == nullptr) return nullptr;
+    for (size_t i = 0; i < nargs; i++) {
+      Py_INCREF(args[i]);
+      PyTuple_SET_ITEM(*tuple, i, args[i]);
+    }
+    PyStrongRef kw = nullptr;
+    if (kwnames != nullptr && PyTuple_GET_SIZE(kwnames) > 0) {
+      kw = PyDict_New();
+      if (kw == nullptr) return nullptr;
+      for (Py_ssize_t i = 0; i < PyTuple_GET_SIZE(kwnames); i++) {
+        if (PyDict_SetItem(*kw, PyTuple_GET_ITEM(kwnames, i), args[nargs + i]) < 0) return nullptr;
+      }
+    }
+    return JSCall_Trampoline_Call(self, *tuple, *kw);
+  }
+
+  try {
+    return CallJSWithPythonArgs(me, args, nargs, kwnames, nullptr);
+  } catch (const Error &err) { PyErr_SetString(PyExc_Exception, err.what()); }
+  return nullptr;
+}
+
+// The JS function is not visible to the Python GC, only the type is traversed
+// The trampoline is tracked so that it can be found by the cycle collector
+static int JSCall_Trampoline_Traverse(PyObject *self, visitproc visit, void *arg) {
+#if PY_MAJOR_VERSION > 3 || (PY_MAJOR_VERSION == 3 && PY_MINOR_VERSION >= 9)
+  Py_VISIT(Py_TYPE(self));
+#endif
+  return 0;
+}
+
 // Finalizer for pymport.js_function
 // Can be called both from Python and JS context
-static PyObject *JSCall_Trampoline_Finalizer(PyObject *self, PyObject *args, PyObject *kw) {
+static void JSCall_Trampoline_Finalizer(PyObject *self) {
   VERBOSE_PYOBJ(CALL, self, "jscall_trampoline finalizer");
   JSCall_Trampoline *me = reinterpret_cast<JSCall_Trampoline *>(self);
+  PyTypeObject *type = Py_TYPE(self);
+  PyObject_GC_UnTrack(self);
 
   auto fn = me->js_fn;
   auto tsfn = me->js_tsfn;
-  if (fn == nullptr) Py_RETURN_NONE;
+  // The queued calls hold references, there are none left
+  delete me->async;
+  if (fn == nullptr) {
+    type->tp_free(self);
+    Py_DECREF(type);
+    return;
+  }
 
   auto context = fn->Env().GetInstanceData<EnvContext>();
+  context->trampoline_store.erase(self);
   auto finalizer = [fn, tsfn, context]() {
     fn->Reset();
     delete fn;
@@ -166,18 +387,36 @@ static PyObject *JSCall_Trampoline_Finalizer(PyObject *self, PyObject *args, PyO
     assert(r == 0);
   }
 
-  Py_RETURN_NONE;
+  type->tp_free(self);
+  Py_DECREF(type);
 }
 
+#if PY_MAJOR_VERSION > 3 || (PY_MAJOR_VERSION == 3 && PY_MINOR_VERSION >= 9)
+static PyMemberDef jscall_trampoline_members[] = {
+  {"__vectorcalloffset__", T_PYSSIZET, offsetof(JSCall_Trampoline, vectorcall), READONLY, nullptr},
+  {nullptr, 0, 0, 0, nullptr}};
+#define JSCALL_TRAMPOLINE_FLAGS (Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC | Py_TPFLAGS_HAVE_VECTORCALL)
+#else
+#define JSCALL_TRAMPOLINE_FLAGS (Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC)
+#endif
+
 static PyType_Slot jscall_trampoline_slots[] = {
   {Py_tp_alloc, reinterpret_cast<void *>(PyType_GenericAlloc)},
   {Py_tp_new, reinterpret_cast<void *>(JSCall_Trampoline_Constructor)},
   {Py_tp_call, reinterpret_cast<void *>(JSCall_Trampoline_Call)},
+  {Py_tp_traverse, reinterpret_cast<void *>(JSCall_Trampoline_Traverse)},
   {Py_tp_dealloc, reinterpret_cast<void *>(JSCall_Trampoline_Finalizer)},
+#if PY_MAJOR_VERSION > 3 || (PY_MAJOR_VERSION == 3 && PY_MINOR_VERSION >= 9)
+  {Py_tp_members, reinterpret_cast<void *>(jscall_trampoline_members)},
+#endif
   {0, 0}};
 
 static PyType_Spec jscall_trampoline_spec = {
-  "pymport.js_function", sizeof(JSCall_Trampoline), 0, Py_TPFLAGS_DEFAULT, jscall_trampoline_slots};
+  "pymport.js_function",
+  sizeof(JSCall_Trampoline),
+  0,
+  JSCALL_TRAMPOLINE_FLAGS,
+  jscall_trampoline_slots};
 
 PyStrongRef PyObjectWrap::JSCall_Trampoline_Type = nullptr;
 
@@ -200,11 +439,123 @@ void PyObjectWrap::InitJSTrampoline() {
 Napi::Value PyObjectWrap::_ToJS_JSFunction(Napi::Env env, const PyWeakRef &py) {
   JSCall_Trampoline *raw = reinterpret_cast<JSCall_Trampoline *>(*py);
   if (raw->js_fn == nullptr) return env.Undefined();
-  return raw->js_fn->Value();
+  Function js_fn = raw->js_fn->Value();
+  if (js_fn.IsEmpty()) return env.Undefined();
+  JSCall_Strengthen(raw);
+  return js_fn;
 }
 
-#define IS_INFO_ARG_KWARGS(n)                                                                                          \
-  (info[n].IsObject() && !info[n].IsArray() && !info[n].IsFunction() && !_InstanceOf(info[n]) && !info[n].IsBuffer())
+#define IS_ARG_KWARGS(v) (v.IsObject() && !v.IsArray() && !v.IsFunction() && !_InstanceOf(v) && !v.IsBuffer())
+#define IS_INFO_ARG_KWARGS(n) IS_ARG_KWARGS(info[n])
+
+static inline Napi::Value VectorcallArg(const CallbackInfo &info, size_t i) {
+  return info[i];
+}
+
+static inline Napi::Value VectorcallArg(const Napi::Array &array, size_t i) {
+  return array.Get(static_cast<uint32_t>(i));
+}
+
+// Converts the JS arguments args[first..argc] - the arguments of a call or the elements of an array
+// A trailing plain object contains the named arguments
+// The values are converted with the schema of a compiled converter when there is one (converter.cc)
+template <typename ARGS>
+void PyObjectWrap::_FromJS_VectorcallArgs(
+  Napi::Env env, const ARGS &args, size_t first, size_t argc, VectorcallArgs &call, const SchemaNode *schema) {
+  Napi::Object kwargs;
+  Napi::Array names;
+  size_t nkw = 0;
+  Napi::Value last = argc > first ? VectorcallArg(args, argc - 1) : Napi::Value();
+  if (argc > first && IS_ARG_KWARGS(last)) {
+    kwargs = last.ToObject();
+    names = kwargs.GetPropertyNames();
+    nkw = names.Length();
+    argc--;
+  } else if (argc > first + 1 && last.IsUndefined()) {
+    argc--;
+  }
+
+  call.Reserve(argc - first + nkw);
+  for (size_t i = first; i < argc; i++) {
+    Napi::Value arg = VectorcallArg(args, i);
+    PyStrongRef v = schema == nullptr ? FromJS(arg) : _FromJS_SchemaTop(env, arg, *schema);
+    EXCEPTION_CHECK(env, v);
+    call.Push(std::move(v));
+  }
+  call.nargs = call.len;
+
+  if (nkw == 0) return;
+  call.kwnames = PyTuple_New(nkw);
+  EXCEPTION_CHECK(env, call.kwnames);
+  for (size_t i = 0; i < nkw; i++) {
+    Napi::Value name = names.Get(i);
+    // Interned names are matched by identity by the callee, they are not cached
+    // as the keyword names are not a bounded set
+    PyStrongRef key = _AttrName(env, name);
+    PyTuple_SET_ITEM(*call.kwnames, i, key.gift());
+    Napi::Value arg = kwargs.Get(name);
+    PyStrongRef v = schema == nullptr ? FromJS(arg) : _FromJS_SchemaTop(env, arg, *schema);
+    EXCEPTION_CHECK(env, v);
+    call.Push(std::move(v));
+  }
+}
+
+void PyObjectWrap::_FromJS_Vectorcall(
+  const CallbackInfo &info, size_t first, VectorcallArgs &call, const SchemaNode *schema) {
+  _FromJS_VectorcallArgs(info.Env(), info, first, info.Length(), call, schema);
+}
+
+void PyObjectWrap::_FromJS_Vectorcall(const Napi::Array &array, VectorcallArgs &call) {
+  _FromJS_VectorcallArgs(array.Env(), array, 0, array.Length(), call);
+}
+
+// Synchronous call, the result is returned as is, without an exception check
+PyStrongRef PyObjectWrap::_Vectorcall(const PyWeakRef &py, const CallbackInfo &info) {
+  if (!PyCallable_Check(*py)) { throw Napi::TypeError::New(info.Env(), "Value not callable"); }
+
+  VectorcallArgs call;
+  _FromJS_Vectorcall(info, 0, call);
+  return PyObject_Vectorcall(*py, call.args + 1, call.nargs | PY_VECTORCALL_ARGUMENTS_OFFSET, *call.kwnames);
+}
+
+// Returns the interned Python string for a method name
+// The names are cached for the lifetime of the environment
+PyWeakRef PyObjectWrap::_MethodName(Napi::Env env, Napi::Value js) {
+  if (!js.IsString()) throw TypeError::New(env, "Method name must be a string");
+  auto context = env.GetInstanceData<EnvContext>();
+  std::string name = js.ToString().Utf8Value();
+  auto it = context->method_names.find(name);
+  if (it != context->method_names.end()) return it->second;
+
+  PyStrongRef py = PyUnicode_InternFromString(name.c_str());
+  EXCEPTION_CHECK(env, py);
+  PyWeakRef r = py;
+  context->method_names.emplace(std::move(name), std::move(py));
+  return r;
+}
+
+// Returns an interned Python string for an attribute name
+// Unlike _MethodName, the name is not cached, it is freed with its last reference
+PyStrongRef PyObjectWrap::_AttrName(Napi::Env env, Napi::Value js) {
+  if (!js.IsString()) throw TypeError::New(env, "Attribute name must be a string");
+  PyStrongRef py = PyUnicode_InternFromString(js.ToString().Utf8Value().c_str());
+  EXCEPTION_CHECK(env, py);
+  return py;
+}
+
+// Calls a method without creating a bound method object
+// Slot 0 of the arguments receives the object
+PyStrongRef PyObjectWrap::_VectorcallMethod(const PyWeakRef &obj, const PyWeakRef &name, VectorcallArgs &call) {
+  call.args[0] = *obj;
+  // Slot 0 is used, PY_VECTORCALL_ARGUMENTS_OFFSET is not allowed
+#if PY_MAJOR_VERSION > 3 || (PY_MAJOR_VERSION == 3 && PY_MINOR_VERSION >= 9)
+  return PyObject_VectorcallMethod(*name, call.args, call.nargs + 1, *call.kwnames);
+#else
+  PyStrongRef fn = PyObject_GetAttr(*obj, *name);
+  if (fn == nullptr) return nullptr;
+  return PyObject_Vectorcall(*fn, call.args + 1, call.nargs, *call.kwnames);
+#endif
+}
 
 // A PyCallExecutor is a C++ lambda wrapper for a Python callable object that
 // also encapsulates the transformed arguments (ie one object is one function call)
@@ -213,8 +564,8 @@ Napi::Value PyObjectWrap::_ToJS_JSFunction(Napi::Env env, const PyWeakRef &py) {
 // A PyCallExecutor handles the persistence of the arguments (PyStrongRefs),
 // but not the function itself which must continue to exist throughout the call
 // Deleting the PyCallExecutor releases the references
-// * in synchronous mode, it is an automatic stack-allocated object
-// * in asynchronous mode, the Execute() method of the AsyncWorker deletes it
+// It is used only by the asynchronous calls, the Execute() method of the AsyncWorker deletes it
+// (the synchronous calls use _Vectorcall)
 PyCallExecutor PyObjectWrap::CreateCallExecutor(const PyWeakRef &py, const CallbackInfo &info) {
   Napi::Env env = info.Env();
 
@@ -269,17 +620,97 @@ PyCallExecutor PyObjectWrap::CreateCallExecutor(const PyWeakRef &py, const Callb
 Value PyObjectWrap::Call(const CallbackInfo &info) {
   Napi::Env env = info.Env();
   PyGILGuard pyGilGuard;
-  PyStrongRef r = CreateCallExecutor(self, info)();
+  PyStrongRef r = _Vectorcall(self, info);
+  EXCEPTION_CHECK(env, r);
+  return New(env, std::move(r));
+}
+
+// Synchronous method call from JavaScript to Python, same as get(name).call(...args)
+Value PyObjectWrap::CallMethod(const CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  PyGILGuard pyGilGuard;
+  PyWeakRef name = _MethodName(env, info[0]);
+  VectorcallArgs call;
+  _FromJS_Vectorcall(info, 1, call);
+  PyStrongRef r = _VectorcallMethod(self, name, call);
   EXCEPTION_CHECK(env, r);
   return New(env, std::move(r));
 }
 
+// Attribute lookup of proxify() (lib/index.js) that does not bind the methods
+// Returns [function] when the attribute is a method found in the type,
+// the caller must pass the object as the first argument, this is what
+// PyObject_VectorcallMethod does internally
+// Returns the attribute itself for everything else and undefined if it does not exist
+// The proxy sees every property access, so the name is not cached
+Value PyObjectWrap::GetMember(const CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  Object obj = NAPI_ARG_PYOBJECT(0);
+  PyObjectWrap *wrap = Unwrap(obj);
+  wrap->Touch(env);
+  PyGILGuard pyGilGuard;
+  PyStrongRef name = _AttrName(env, info[1]);
+
+#if PY_VERSION_HEX < 0x030D0000
+  // Private in all versions, removed from the headers in 3.13
+  PyObject *raw = nullptr;
+  bool unbound = _PyObject_GetMethod(*wrap->self, *name, &raw) == 1;
+  PyStrongRef attr = raw;
+#else
+  // There is no public equivalent of _PyObject_GetMethod, the bound method is created
+  // and immediately unpacked - the JS side still receives the unbound function,
+  // but the allocation is not saved
+  PyStrongRef attr = PyObject_GetAttr(*wrap->self, *name);
+  bool unbound = false;
+  if (attr != nullptr && PyMethod_Check(*attr) && PyMethod_GET_SELF(*attr) == *wrap->self) {
+    attr = PyStrongRef(PyWeakRef(PyMethod_GET_FUNCTION(*attr)));
+    unbound = true;
+  }
+#endif
+  if (attr == nullptr) {
+    PyErr_Clear();
+    return env.Undefined();
+  }
+
+  Napi::Value r = New(env, std::move(attr));
+  if (!unbound) return r;
+  Array method = Array::New(env, 1);
+  method.Set(0u, r);
+  return method;
+}
+
+// Calls this once for every element of an array of argument lists
+// with a single acquisition of the GIL
+Value PyObjectWrap::CallMany(const CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  Array calls = NAPI_ARG_ARRAY(0);
+  Object opts = NAPI_OPT_ARG_OBJECT(1);
+  bool tojs = !opts.IsEmpty() && opts.Has("toJS") && opts.Get("toJS").ToBoolean().Value();
+
+  PyGILGuard pyGilGuard;
+  if (!PyCallable_Check(*self)) { throw Napi::TypeError::New(env, "Value not callable"); }
+  uint32_t len = calls.Length();
+  Array results = Array::New(env, len);
+  for (uint32_t i = 0; i < len; i++) {
+    HandleScope scope(env);
+    Napi::Value args = calls.Get(i);
+    if (!args.IsArray()) throw TypeError::New(env, "Arguments must be arrays");
+    VectorcallArgs call;
+    _FromJS_Vectorcall(args.As<Array>(), call);
+    PyStrongRef r =
+      PyObject_Vectorcall(*self, call.args + 1, call.nargs | PY_VECTORCALL_ARGUMENTS_OFFSET, *call.kwnames);
+    EXCEPTION_CHECK(env, r);
+    results.Set(i, tojs ? ToJS(env, r, {-1, true, false}) : New(env, std::move(r)));
+  }
+  return results;
+}
+
 // Synchronous call from JavaScript to Python (the callable is in the context)
 Value PyObjectWrap::_CallableTrampoline(const CallbackInfo &info) {
   Napi::Env env = info.Env();
   PyGILGuard pyGilGuard;
   PyObject *py = reinterpret_cast<PyObject *>(info.Data());
-  PyStrongRef r = CreateCallExecutor(py, info)();
+  PyStrongRef r = _Vectorcall(py, info);
   EXCEPTION_CHECK(env, r);
   return New(env, std::move(r));
 }
@@ -364,7 +795,9 @@ PyStrongRef PyObjectWrap::NewJSFunction(Function js_fn) {
   // Pass the JS reference to the callback
   auto *raw = reinterpret_cast<JSCall_Trampoline *>(*trampoline);
   raw->js_fn = new FunctionReference(Persistent(js_fn));
-  raw->js_tsfn = new ThreadSafeFunction(ThreadSafeFunction::New(env, js_fn, "pymport.js_function", 0, 1));
+  // The TSFN is used only to jump to the V8 main thread, the function is always called
+  // through js_fn - the TSFN must not hold a second reference that would escape the cycle collector
+  raw->js_tsfn = new ThreadSafeFunction(ThreadSafeFunction::New(env, Function(), "pymport.js_function", 0, 1));
   // Sometimes V8 won't destroy some objects - so these TSFN should not block the event loop's exit
   // This means that the last call of the program cannot be an async Python call
   // that callbacks a JS function - the event loop won't wait for it
@@ -372,6 +805,7 @@ PyStrongRef PyObjectWrap::NewJSFunction(Function js_fn) {
 
   auto context = env.GetInstanceData<EnvContext>();
   context->tsfn_store.insert(raw->js_tsfn);
+  context->trampoline_store.insert(*trampoline);
 
   return trampoline;
 }
@@ -381,7 +815,55 @@ Value PyObjectWrap::Functor(const CallbackInfo &info) {
   Napi::Env env = info.Env();
 
   auto fn = NAPI_ARG_FUNC(0);
+  Object opts = NAPI_OPT_ARG_OBJECT(1);
+
+  JSCall_Args args_mode = JSCALL_ARGS_WRAP;
+  int args_depth = -1;
+  if (!opts.IsEmpty() && opts.Has("convert")) {
+    Napi::Value convert = opts.Get("convert");
+    if (convert.IsNumber()) {
+      args_mode = JSCALL_ARGS_TOJS;
+      double depth = convert.ToNumber().DoubleValue();
+      if (std::isnan(depth) || depth < 0 || (!std::isinf(depth) && std::floor(depth) != depth))
+        throw RangeError::New(env, "convert depth must be a non-negative integer or Infinity");
+      if (depth <= static_cast<double>(INT32_MAX)) args_depth = static_cast<int>(depth);
+    } else {
+      std::string mode = convert.ToString().Utf8Value();
+      if (mode == "value")
+        args_mode = JSCALL_ARGS_VALUE;
+      else if (mode != "wrap")
+        throw TypeError::New(env, "convert must be 'wrap', 'value' or a number");
+    }
+  }
+
+  std::unique_ptr<JSCall_Async> async;
+  if (!opts.IsEmpty() && opts.Has("mode")) {
+    std::string mode = opts.Get("mode").ToString().Utf8Value();
+    if (mode == "async") {
+      async = std::make_unique<JSCall_Async>(JSCall_Async{1024, false, 0, 0});
+      if (opts.Has("queue")) {
+        Napi::Value queue = opts.Get("queue");
+        if (!queue.IsNumber() || queue.ToNumber().DoubleValue() < 1)
+          throw TypeError::New(env, "queue must be a positive number");
+        async->limit = static_cast<size_t>(queue.ToNumber().DoubleValue());
+      }
+      if (opts.Has("overflow")) {
+        std::string overflow = opts.Get("overflow").ToString().Utf8Value();
+        if (overflow == "drop")
+          async->drop = true;
+        else if (overflow != "block")
+          throw TypeError::New(env, "overflow must be 'block' or 'drop'");
+      }
+    } else if (mode != "sync") {
+      throw TypeError::New(env, "mode must be 'sync' or 'async'");
+    }
+  }
+
   PyStrongRef obj = NewJSFunction(fn);
   EXCEPTION_CHECK(env, obj);
+  auto raw = reinterpret_cast<JSCall_Trampoline *>(*obj);
+  raw->async = async.release();
+  raw->args_mode = args_mode;
+  raw->args_depth = args_depth;
   return New(env, std::move(obj));
 }
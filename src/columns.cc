@@ -0,0 +1,308 @@
+#include <cstring>
+#include <string>
+
+#include "pymport.h"
+#include "pystackobject.h"
+#include "values.h"
+
+using namespace Napi;
+using namespace pymport;
+
+// Columnar conversion of tabular data - toColumns()
+//
+// The result is {columnName: column} where every numeric column is copied once to a TypedArray:
+// * a dict of 1-D buffers (numpy arrays, array.array...) - refer to ndarray.cc
+// * an object implementing the DataFrame interchange protocol (__dataframe__), such as a
+//   pandas DataFrame - the columns are copied directly from the exported memory
+//
+// The interchange columns can also carry:
+// * missing values - the TypedArray gets a `valid` Uint8Array property with 0 for every
+//   missing value (only when there are missing values, NaN is used for the floats)
+// * dictionary-encoded (categorical) values - the TypedArray holds the codes and gets a
+//   `categories` property with the converted categories
+// * strings - these become arrays of strings with null for the missing values
+//
+// https://data-apis.org/dataframe-protocol/latest/API.html
+
+// The enumerations of the DataFrame interchange protocol
+enum DtypeKind {
+  DTYPE_INT = 0,
+  DTYPE_UINT = 1,
+  DTYPE_FLOAT = 2,
+  DTYPE_BOOL = 20,
+  DTYPE_STRING = 21,
+  DTYPE_DATETIME = 22,
+  DTYPE_CATEGORICAL = 23
+};
+enum ColumnNullType { NON_NULLABLE = 0, USE_NAN = 1, USE_SENTINEL = 2, USE_BITMASK = 3, USE_BYTEMASK = 4 };
+
+// (kind, bitwidth, format, endianness)
+struct InterchangeDtype {
+  long kind;
+  long bitwidth;
+  const char *format;
+  const char *endianness;
+};
+
+// A buffer of the interchange protocol with its dtype
+struct PyObjectWrap::InterchangeBuffer {
+  const char *ptr;
+  Py_ssize_t bufsize;
+  InterchangeDtype dtype;
+};
+
+static bool GetInterchangeType(const InterchangeDtype &dtype, napi_typedarray_type &type) {
+  switch (dtype.kind) {
+    case DTYPE_INT:
+    case DTYPE_DATETIME:
+      switch (dtype.bitwidth) {
+        case 8:
+          type = napi_int8_array;
+          return true;
+        case 16:
+          type = napi_int16_array;
+          return true;
+        case 32:
+          type = napi_int32_array;
+          return true;
+        case 64:
+          type = napi_bigint64_array;
+          return true;
+      }
+      return false;
+    case DTYPE_UINT:
+    case DTYPE_BOOL:
+      switch (dtype.bitwidth) {
+        case 8:
+          type = napi_uint8_array;
+          return true;
+        case 16:
+          type = napi_uint16_array;
+          return true;
+        case 32:
+          type = napi_uint32_array;
+          return true;
+        case 64:
+          type = napi_biguint64_array;
+          return true;
+      }
+      return false;
+    case DTYPE_FLOAT:
+      switch (dtype.bitwidth) {
+        case 32:
+          type = napi_float32_array;
+          return true;
+        case 64:
+          type = napi_float64_array;
+          return true;
+      }
+      return false;
+  }
+  return false;
+}
+
+// Sign-extended integer element, for the sentinel values
+static int64_t ReadInteger(const char *data, Py_ssize_t i, long bitwidth) {
+  switch (bitwidth) {
+    case 8:
+      return reinterpret_cast<const int8_t *>(data)[i];
+    case 16:
+      return reinterpret_cast<const int16_t *>(data)[i];
+    case 32:
+      return reinterpret_cast<const int32_t *>(data)[i];
+    default:
+      return reinterpret_cast<const int64_t *>(data)[i];
+  }
+}
+
+static inline bool ReadBit(const char *data, Py_ssize_t i) {
+  return (static_cast<uint8_t>(data[i >> 3]) >> (i & 7)) & 1;
+}
+
+static void ParseDtype(Napi::Env env, PyObject *tuple, InterchangeDtype &dtype) {
+  if (!PyArg_ParseTuple(tuple, "llss", &dtype.kind, &dtype.bitwidth, &dtype.format, &dtype.endianness)) {
+    PyErr_Clear();
+    throw TypeError::New(env, "Invalid DataFrame interchange dtype");
+  }
+  if (dtype.endianness[0] == '>') throw TypeError::New(env, "Big-endian columns are not supported");
+}
+
+// Reads the {"data", "validity", "offsets"} element of get_buffers(), returns false if it is None
+bool PyObjectWrap::_InterchangeBuffer(
+  Napi::Env env, const PyWeakRef &buffers, const char *name, InterchangeBuffer &buffer) {
+  PyWeakRef entry = PyDict_GetItemString(*buffers, name);
+  if (entry == nullptr || *entry == Py_None) return false;
+  if (!PyTuple_Check(*entry) || PyTuple_GET_SIZE(*entry) != 2)
+    throw TypeError::New(env, "Invalid DataFrame interchange buffer");
+
+  PyWeakRef buf = PyTuple_GET_ITEM(*entry, 0);
+  PyStrongRef ptr = PyObject_GetAttrString(*buf, "ptr");
+  EXCEPTION_CHECK(env, ptr);
+  PyStrongRef bufsize = PyObject_GetAttrString(*buf, "bufsize");
+  EXCEPTION_CHECK(env, bufsize);
+  buffer.ptr = static_cast<const char *>(PyLong_AsVoidPtr(*ptr));
+  buffer.bufsize = PyLong_AsSsize_t(*bufsize);
+  EXCEPTION_CHECK(env, static_cast<int>(PyErr_Occurred() != nullptr));
+  ParseDtype(env, PyTuple_GET_ITEM(*entry, 1), buffer.dtype);
+  return true;
+}
+
+static Py_ssize_t CallSize(PyObject *obj, const char *method) {
+  PyStrongRef r = PyObject_CallMethod(obj, method, nullptr);
+  if (r == nullptr) return -1;
+  return PyLong_AsSsize_t(*r);
+}
+
+Napi::Value PyObjectWrap::_ToJS_InterchangeColumn(Napi::Env env, const PyWeakRef &col) {
+  Py_ssize_t size = CallSize(*col, "size");
+  EXCEPTION_CHECK(env, static_cast<int>(PyErr_Occurred() != nullptr));
+  PyStrongRef py_offset = PyObject_GetAttrString(*col, "offset");
+  EXCEPTION_CHECK(env, py_offset);
+  Py_ssize_t offset = PyLong_AsSsize_t(*py_offset);
+  EXCEPTION_CHECK(env, static_cast<int>(PyErr_Occurred() != nullptr));
+
+  PyStrongRef py_dtype = PyObject_GetAttrString(*col, "dtype");
+  EXCEPTION_CHECK(env, py_dtype);
+  InterchangeDtype dtype;
+  ParseDtype(env, *py_dtype, dtype);
+
+  long null_type;
+  PyObject *null_value;
+  PyStrongRef py_null = PyObject_GetAttrString(*col, "describe_null");
+  EXCEPTION_CHECK(env, py_null);
+  if (!PyArg_ParseTuple(*py_null, "lO", &null_type, &null_value)) {
+    PyErr_Clear();
+    throw TypeError::New(env, "Invalid DataFrame interchange null description");
+  }
+  int64_t null_int = 0;
+  if (null_value != Py_None) {
+    null_int = PyLong_AsLongLong(null_value);
+    EXCEPTION_CHECK(env, static_cast<int>(PyErr_Occurred() != nullptr));
+  }
+
+  PyStrongRef buffers = PyObject_CallMethod(*col, "get_buffers", nullptr);
+  EXCEPTION_CHECK(env, buffers);
+  if (!PyDict_Check(*buffers)) throw TypeError::New(env, "Invalid DataFrame interchange buffers");
+  InterchangeBuffer data, validity, offsets;
+  if (!_InterchangeBuffer(env, buffers, "data", data)) throw TypeError::New(env, "Column without data");
+  bool has_validity = _InterchangeBuffer(env, buffers, "validity", validity);
+  bool has_offsets = _InterchangeBuffer(env, buffers, "offsets", offsets);
+
+  // The validity of every element, only bitmasks, bytemasks and sentinels are materialized
+  auto is_valid = [&](Py_ssize_t i) -> bool {
+    switch (null_type) {
+      case USE_BITMASK:
+        return !has_validity || ReadBit(validity.ptr, offset + i) != (null_int != 0);
+      case USE_BYTEMASK:
+        return !has_validity || (validity.ptr[offset + i] != 0) != (null_int != 0);
+      case USE_SENTINEL:
+        return ReadInteger(data.ptr, offset + i, data.dtype.bitwidth) != null_int;
+      default:
+        return true;
+    }
+  };
+
+  if (dtype.kind == DTYPE_STRING) {
+    if (!has_offsets || (offsets.dtype.bitwidth != 32 && offsets.dtype.bitwidth != 64))
+      throw TypeError::New(env, "String column without offsets");
+    Napi::Array strings = Napi::Array::New(env, size);
+    for (Py_ssize_t i = 0; i < size; i++) {
+      if (!is_valid(i)) {
+        strings.Set(i, env.Null());
+        continue;
+      }
+      int64_t start = ReadInteger(offsets.ptr, offset + i, offsets.dtype.bitwidth);
+      int64_t end = ReadInteger(offsets.ptr, offset + i + 1, offsets.dtype.bitwidth);
+      strings.Set(i, Napi::String::New(env, data.ptr + start, static_cast<size_t>(end - start)));
+    }
+    return strings;
+  }
+
+  napi_typedarray_type type;
+  ArrayBuffer array;
+  if (data.dtype.kind == DTYPE_BOOL && data.dtype.bitwidth == 1) {
+    // Arrow-style bit-packed booleans are unpacked to bytes
+    type = napi_uint8_array;
+    array = ArrayBuffer::New(env, size);
+    auto dst = static_cast<uint8_t *>(array.Data());
+    for (Py_ssize_t i = 0; i < size; i++) dst[i] = ReadBit(data.ptr, offset + i);
+  } else {
+    if (!GetInterchangeType(data.dtype, type))
+      throw TypeError::New(env, "Column format '" + std::string(data.dtype.format) + "' is not supported");
+    size_t itemsize = data.dtype.bitwidth / 8;
+    if (static_cast<size_t>(data.bufsize) < (offset + size) * itemsize)
+      throw RangeError::New(env, "Column buffer is too small");
+    array = ArrayBuffer::New(env, size * itemsize);
+    if (size > 0) memcpy(array.Data(), data.ptr + offset * itemsize, size * itemsize);
+  }
+
+  napi_value raw;
+  napi_status status = napi_create_typedarray(env, type, size, array, 0, &raw);
+  if (status != napi_ok) throw Error::New(env);
+  Object result(env, raw);
+
+  if (null_type == USE_BITMASK || null_type == USE_BYTEMASK || null_type == USE_SENTINEL) {
+    Uint8Array valid = Uint8Array::New(env, size);
+    bool missing = false;
+    for (Py_ssize_t i = 0; i < size; i++) {
+      bool v = is_valid(i);
+      valid[static_cast<size_t>(i)] = v;
+      missing = missing || !v;
+    }
+    if (missing) result.Set("valid", valid);
+  }
+
+  if (dtype.kind == DTYPE_CATEGORICAL) {
+    PyStrongRef categorical = PyObject_GetAttrString(*col, "describe_categorical");
+    EXCEPTION_CHECK(env, categorical);
+    PyWeakRef categories = PyDict_Check(*categorical) ? PyDict_GetItemString(*categorical, "categories") : nullptr;
+    if (categories != nullptr && *categories != Py_None)
+      result.Set("categories", _ToJS_InterchangeColumn(env, categories));
+  }
+
+  return result;
+}
+
+Value PyObjectWrap::ToColumns(const CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  PyGILGuard pyGilGuard;
+  Object r = Object::New(env);
+
+  if (PyDict_Check(*self)) {
+    PyWeakRef key = nullptr, value = nullptr;
+    Py_ssize_t pos = 0;
+    while (PyDict_Next(*self, &pos, &key, &value)) {
+      PyStrongRef name = PyObject_Str(*key);
+      EXCEPTION_CHECK(env, name);
+      Napi::Value column = _ToTypedArray(env, value);
+      if (column.As<Object>().Get("shape").As<Napi::Array>().Length() != 1)
+        throw TypeError::New(env, "Columns must be 1-dimensional");
+      r.Set(_ToJS_String(env, name), column);
+    }
+    return r;
+  }
+
+  if (!PyObject_HasAttrString(*self, "__dataframe__"))
+    throw TypeError::New(env, "Object is neither a dict of arrays nor a DataFrame");
+  PyStrongRef df = PyObject_CallMethod(*self, "__dataframe__", nullptr);
+  EXCEPTION_CHECK(env, df);
+  Py_ssize_t chunks = CallSize(*df, "num_chunks");
+  EXCEPTION_CHECK(env, static_cast<int>(PyErr_Occurred() != nullptr));
+  if (chunks > 1) throw TypeError::New(env, "Chunked DataFrames are not supported");
+
+  PyStrongRef names = PyObject_CallMethod(*df, "column_names", nullptr);
+  EXCEPTION_CHECK(env, names);
+  PyStrongRef iter = PyObject_GetIter(*names);
+  EXCEPTION_CHECK(env, iter);
+  PyStrongRef name = nullptr;
+  while ((name = PyIter_Next(*iter)) != nullptr) {
+    PyStrongRef col = PyObject_CallMethod(*df, "get_column_by_name", "O", *name);
+    EXCEPTION_CHECK(env, col);
+    PyStrongRef str = PyObject_Str(*name);
+    EXCEPTION_CHECK(env, str);
+    r.Set(_ToJS_String(env, str), _ToJS_InterchangeColumn(env, col));
+  }
+  EXCEPTION_CHECK(env, static_cast<int>(PyErr_Occurred() != nullptr));
+
+  return r;
+}
@@ -0,0 +1,278 @@
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "pymport.h"
+#include "pystackobject.h"
+#include "values.h"
+
+using namespace Napi;
+using namespace pymport;
+
+// Schema-compiled converters
+//
+// _FromJS discovers the shape of every value - the type dispatch, the property names,
+// the prototype, PyObject and proxified PyObject checks. When the same shape is converted
+// over and over again, a converter compiled from a declared schema skips all of it:
+// * a string is a scalar type: 'int', 'float', 'str', 'bool' or 'any' (the generic conversion),
+//   a trailing '?' allows null and undefined which become None
+// * an array with a single element is a list of elements of this schema
+// * an object is a dict with the declared fields, the other properties are ignored
+//
+// Any mismatch throws a TypeError with the path of the offending value
+
+struct PyObjectWrap::SchemaNode {
+  enum Type { ANY, INT, FLOAT, STR, BOOL, LIST, DICT } type;
+  bool nullable;
+  // DICT fields
+  std::vector<std::string> names;
+  std::vector<PyStrongRef> keys;
+  // DICT fields or the LIST element
+  std::vector<std::unique_ptr<SchemaNode>> children;
+};
+
+// Thrown during the conversion, the path is built while unwinding
+struct SchemaMismatch {
+  std::string path;
+  const char *expected;
+};
+
+static const char *type_names[] = {"any", "int", "float", "str", "bool", "list", "dict"};
+
+std::unique_ptr<PyObjectWrap::SchemaNode> PyObjectWrap::_CompileSchema(Napi::Env env, Napi::Value schema) {
+  auto node = std::make_unique<SchemaNode>();
+  node->nullable = false;
+
+  if (schema.IsString()) {
+    std::string type = schema.As<Napi::String>().Utf8Value();
+    if (!type.empty() && type.back() == '?') {
+      node->nullable = true;
+      type.pop_back();
+    }
+    if (type == "any")
+      node->type = SchemaNode::ANY;
+    else if (type == "int")
+      node->type = SchemaNode::INT;
+    else if (type == "float")
+      node->type = SchemaNode::FLOAT;
+    else if (type == "str")
+      node->type = SchemaNode::STR;
+    else if (type == "bool")
+      node->type = SchemaNode::BOOL;
+    else
+      throw TypeError::New(env, "Invalid schema type '" + type + "'");
+    return node;
+  }
+
+  if (schema.IsArray()) {
+    auto array = schema.As<Napi::Array>();
+    if (array.Length() != 1) throw TypeError::New(env, "A list schema must have exactly one element");
+    node->type = SchemaNode::LIST;
+    node->children.push_back(_CompileSchema(env, array.Get(static_cast<uint32_t>(0))));
+    return node;
+  }
+
+  if (schema.IsObject() && !schema.IsFunction()) {
+    auto object = schema.As<Object>();
+    node->type = SchemaNode::DICT;
+    for (auto const &el : object.GetPropertyNames()) {
+      Napi::Value name = el.second;
+      node->names.push_back(name.As<Napi::String>().Utf8Value());
+      PyStrongRef key = PyUnicode_InternFromString(node->names.back().c_str());
+      EXCEPTION_CHECK(env, key);
+      node->keys.push_back(std::move(key));
+      node->children.push_back(_CompileSchema(env, object.Get(name)));
+    }
+    return node;
+  }
+
+  throw TypeError::New(env, "Invalid schema");
+}
+
+static inline bool IsNullish(napi_valuetype type) {
+  return type == napi_null || type == napi_undefined;
+}
+
+// Returns a strong reference
+PyStrongRef PyObjectWrap::_FromJS_SchemaScalar(Napi::Env env, napi_value v, const SchemaNode &node) {
+  napi_status status;
+  switch (node.type) {
+    case SchemaNode::INT:
+    case SchemaNode::FLOAT: {
+      double raw;
+      status = napi_get_value_double(env, v, &raw);
+      if (status != napi_ok) break;
+      if (node.type == SchemaNode::FLOAT) {
+        PyStrongRef py = PyFloat_FromDouble(raw);
+        EXCEPTION_CHECK(env, py);
+        return py;
+      }
+      double integer;
+      if (modf(raw, &integer) != 0 || std::isinf(raw) || std::isnan(raw)) break;
+      PyStrongRef py = PyLong_FromDouble(raw);
+      EXCEPTION_CHECK(env, py);
+      return py;
+    }
+    case SchemaNode::BOOL: {
+      bool raw;
+      status = napi_get_value_bool(env, v, &raw);
+      if (status != napi_ok) break;
+      return PyStrongRef(PyWeakRef(raw ? Py_True : Py_False));
+    }
+    case SchemaNode::STR: {
+      napi_valuetype type;
+      status = napi_typeof(env, v, &type);
+      if (status != napi_ok || type != napi_string) break;
+      return _FromJS_String(Napi::Value(env, v));
+    }
+    default:
+      break;
+  }
+  throw SchemaMismatch{"", type_names[node.type]};
+}
+
+// Returns a strong reference
+PyStrongRef PyObjectWrap::_FromJS_Schema(Napi::Env env, napi_value v, const SchemaNode &node, PyObjectStore &store) {
+  if (node.nullable) {
+    napi_valuetype type;
+    napi_status status = napi_typeof(env, v, &type);
+    if (status != napi_ok) throw Error::New(env);
+    if (IsNullish(type)) return PyStrongRef(PyWeakRef(Py_None));
+  }
+
+  switch (node.type) {
+    case SchemaNode::ANY:
+      return _FromJS(Napi::Value(env, v), store);
+
+    case SchemaNode::LIST: {
+      bool is_array;
+      napi_status status = napi_is_array(env, v, &is_array);
+      if (status != napi_ok || !is_array) throw SchemaMismatch{"", type_names[node.type]};
+      uint32_t len;
+      status = napi_get_array_length(env, v, &len);
+      if (status != napi_ok) throw Error::New(env);
+
+      PyStrongRef list = PyList_New(len);
+      EXCEPTION_CHECK(env, list);
+      const SchemaNode &element = *node.children[0];
+      for (uint32_t i = 0; i < len; i++) {
+        napi_value el;
+        status = napi_get_element(env, v, i, &el);
+        if (status != napi_ok) throw Error::New(env);
+        try {
+          PyStrongRef item = _FromJS_Schema(env, el, element, store);
+          // The list is new and empty, this steals the reference
+          PyList_SET_ITEM(*list, i, item.gift());
+        } catch (SchemaMismatch &err) {
+          err.path = "[" + std::to_string(i) + "]" + err.path;
+          throw;
+        }
+      }
+      return list;
+    }
+
+    case SchemaNode::DICT: {
+      napi_valuetype type;
+      napi_status status = napi_typeof(env, v, &type);
+      if (status != napi_ok || type != napi_object) throw SchemaMismatch{"", type_names[node.type]};
+
+      PyStrongRef dict = PyDict_New();
+      EXCEPTION_CHECK(env, dict);
+      for (size_t i = 0; i < node.names.size(); i++) {
+        napi_value el;
+        status = napi_get_named_property(env, v, node.names[i].c_str(), &el);
+        if (status != napi_ok) throw Error::New(env);
+        try {
+          PyStrongRef item = _FromJS_Schema(env, el, *node.children[i], store);
+          // This is the only Py***_Set that does not steal a reference
+          int r = PyDict_SetItem(*dict, *node.keys[i], *item);
+          EXCEPTION_CHECK(env, r);
+        } catch (SchemaMismatch &err) {
+          err.path = "." + node.names[i] + err.path;
+          throw;
+        }
+      }
+      return dict;
+    }
+
+    default:
+      return _FromJS_SchemaScalar(env, v, node);
+  }
+}
+
+PyStrongRef PyObjectWrap::_FromJS_SchemaTop(Napi::Env env, Napi::Value v, const SchemaNode &node) {
+  PyObjectStore store;
+  try {
+    return _FromJS_Schema(env, v, node, store);
+  } catch (const SchemaMismatch &err) {
+    std::string where = err.path.empty() ? "" : " at " + err.path;
+    throw TypeError::New(env, "Schema mismatch" + where + ", expected " + err.expected);
+  }
+}
+
+// converter.convert(value) -> PyObject
+Value PyObjectWrap::ConverterConvert(const CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  PyGILGuard pyGilGuard;
+  const SchemaNode &node = **static_cast<SchemaRef *>(info.Data());
+
+  if (info.Length() < 1) throw Error::New(env, "Missing mandatory argument");
+  PyStrongRef r = _FromJS_SchemaTop(env, info[0], node);
+  return New(env, std::move(r));
+}
+
+// converter.call(fn, ...args, kwargs?) -> PyObject
+// Every argument is converted with the schema without creating intermediate PyObjects,
+// the arguments are passed by vectorcall, a trailing plain object contains the named arguments
+Value PyObjectWrap::ConverterCall(const CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  PyGILGuard pyGilGuard;
+  const SchemaNode &node = **static_cast<SchemaRef *>(info.Data());
+
+  // The proxified functions are not instances of PyObject
+  Object fn = _FunctionOf(info[0]) ? info[0].ToObject().Get("__PyObject__").ToObject() : NAPI_ARG_PYOBJECT(0);
+  PyObjectWrap *callable = Unwrap(fn);
+  callable->Touch(env);
+  if (!PyCallable_Check(*callable->self)) { throw Napi::TypeError::New(env, "Value not callable"); }
+
+  VectorcallArgs call;
+  _FromJS_Vectorcall(info, 1, call, &node);
+  PyStrongRef r =
+    PyObject_Vectorcall(*callable->self, call.args + 1, call.nargs | PY_VECTORCALL_ARGUMENTS_OFFSET, *call.kwnames);
+  EXCEPTION_CHECK(env, r);
+  return New(env, std::move(r));
+}
+
+// Each function of the converter holds a reference to the compiled schema,
+// the functions can outlive the converter object
+Function PyObjectWrap::_NewConverterFunction(
+  Napi::Env env, Napi::Value (*cb)(const CallbackInfo &), const char *name, const SchemaRef &schema) {
+  auto ref = new SchemaRef(schema);
+  Function fn = Function::New(env, cb, name, ref);
+  fn.AddFinalizer(
+    [](Napi::BasicEnv, SchemaRef *ref) {
+      // The interned keys are Python objects
+      // Skip if Python has been shut down, refer to PyObjectWrap::Finalize
+      if (active_environments == 0) return;
+      PyGILGuard pyGilGuard;
+      delete ref;
+    },
+    ref);
+  return fn;
+}
+
+Value PyObjectWrap::CompileConverter(const CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  PyGILGuard pyGilGuard;
+
+  if (info.Length() < 1) throw Error::New(env, "Missing mandatory argument");
+  SchemaRef schema = _CompileSchema(env, info[0]);
+
+  Object converter = Object::New(env);
+  converter.DefineProperties(
+    {Napi::PropertyDescriptor::Value(
+       "convert", _NewConverterFunction(env, ConverterConvert, "convert", schema), napi_enumerable),
+     Napi::PropertyDescriptor::Value("call", _NewConverterFunction(env, ConverterCall, "call", schema), napi_enumerable)});
+  return converter;
+}
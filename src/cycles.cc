@@ -0,0 +1,191 @@
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "pymport.h"
+#include "pystackobject.h"
+#include "values.h"
+
+using namespace Napi;
+using namespace pymport;
+
+// Cross-heap cycle collector
+//
+// A JS function passed to Python becomes a JSCall_Trampoline that holds a
+// persistent reference to the function. If the function also captures a
+// PyObject (directly or indirectly), there is a JS -> Python -> JS cycle
+// that neither GC can see:
+//
+//   PyObject (JS) -> PyObject (Python) -> ... -> trampoline -> function (JS) -> PyObject (JS)
+//
+// The collector finds the trampolines that are kept alive by Python only
+// through objects that are themselves kept alive by the JS wrappers of
+// this environment. For each such trampoline, the strong reference is moved
+// into the V8 heap - the function is attached to every JS wrapper that
+// reaches it - and the trampoline reference is downgraded to a weak one.
+// The whole cycle is then visible to V8 which can collect it, this
+// releases the Python objects which releases the trampoline.
+//
+// The Python side is computed in the same way as the Python GC does it:
+// * gc_refs = refcount - references from other tracked objects - references from our JS wrappers
+// * the tracked objects with gc_refs > 0 are referenced from outside (the Python roots)
+// * everything that is reachable from them is rooted
+//
+// Python cannot store a weak trampoline somewhere rooted without first
+// reaching it, and as it is not rooted, it can be reached only from JS:
+// * by calling it or by converting it back to JS
+// * through one of the JS wrappers that reach it (the anchors) - passing it
+//   to Python or calling any of its methods that can run Python code
+// All of these upgrade it back to a strong reference before Python gets
+// the chance to store it, the JS function cannot be collected while Python
+// can still reach it. Touching an anchor upgrades all the weak trampolines
+// of the environment, the next collection downgrades them again.
+// The only exceptions are the Python finalizers (__del__ and the weakref
+// callbacks) of the unrooted objects and gc.get_referrers() - they can
+// reach a weak trampoline without going through JS.
+
+// This is a stop-the-world operation that walks the whole Python heap, it is meant
+// to be called periodically by long-running applications
+
+typedef std::unordered_map<PyObject *, Py_ssize_t> GCRefs;
+
+static int VisitDecref(PyObject *obj, void *arg) {
+  auto refs = static_cast<GCRefs *>(arg);
+  auto it = refs->find(obj);
+  if (it != refs->end()) it->second--;
+  return 0;
+}
+
+static int VisitPush(PyObject *obj, void *arg) {
+  auto stack = static_cast<std::vector<PyObject *> *>(arg);
+  stack->push_back(obj);
+  return 0;
+}
+
+static inline void Traverse(PyObject *obj, visitproc visit, void *arg) {
+  traverseproc traverse = Py_TYPE(obj)->tp_traverse;
+  if (traverse != nullptr) traverse(obj, visit, arg);
+}
+
+Value PyObjectWrap::CollectCycles(const CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  PyGILGuard pyGilGuard;
+  auto context = env.GetInstanceData<EnvContext>();
+
+  size_t weakened = 0;
+  size_t strengthened = 0;
+  // (wrapped object, trampoline) pairs, the strong references guarantee
+  // that nothing is freed by the JS GC while creating the JS anchors
+  std::vector<std::pair<PyStrongRef, PyStrongRef>> anchors;
+
+  if (!context->trampoline_store.empty()) {
+    PyStrongRef gc = PyImport_ImportModule("gc");
+    EXCEPTION_CHECK(env, gc);
+    PyStrongRef objects = PyObject_CallMethod(*gc, "get_objects", nullptr);
+    EXCEPTION_CHECK(env, objects);
+    Py_ssize_t len = PyList_Size(*objects);
+
+    // gc_refs, the list holds one reference to every object
+    GCRefs refs;
+    refs.reserve(static_cast<size_t>(len));
+    for (Py_ssize_t i = 0; i < len; i++) {
+      PyObject *obj = PyList_GET_ITEM(*objects, i);
+      refs[obj] = Py_REFCNT(obj) - 1;
+    }
+    for (Py_ssize_t i = 0; i < len; i++) Traverse(PyList_GET_ITEM(*objects, i), VisitDecref, &refs);
+    context->object_store.for_each([&refs](PyObject *obj, PyObjectWrap *) {
+      auto it = refs.find(obj);
+      if (it != refs.end()) it->second--;
+    });
+
+    // Mark everything reachable from the Python roots
+    std::unordered_set<PyObject *> rooted;
+    std::vector<PyObject *> stack;
+    for (auto const &r : refs)
+      if (r.second > 0) stack.push_back(r.first);
+    while (!stack.empty()) {
+      PyObject *obj = stack.back();
+      stack.pop_back();
+      if (refs.count(obj) == 0 || !rooted.insert(obj).second) continue;
+      Traverse(obj, VisitPush, &stack);
+    }
+
+    // Rooted trampolines that were downgraded by a previous collection
+    for (auto t : context->trampoline_store) {
+      auto trampoline = reinterpret_cast<JSCall_Trampoline *>(t);
+      if (trampoline->weak && rooted.count(t) > 0) {
+        VERBOSE_PYOBJ(CALL, t, "jscall_trampoline strengthen");
+        trampoline->js_fn->Ref();
+        trampoline->weak = false;
+        strengthened++;
+      }
+    }
+
+    // Trampolines reachable from the wrapped objects that are not rooted
+    // Most wrapped objects are rooted, the search is limited to the others
+    context->object_store.for_each([&](PyObject *obj, PyObjectWrap *) {
+      if (refs.count(obj) == 0 || rooted.count(obj) > 0) return;
+      std::unordered_set<PyObject *> visited;
+      std::vector<PyObject *> search = {obj};
+      while (!search.empty()) {
+        PyObject *o = search.back();
+        search.pop_back();
+        if (refs.count(o) == 0 || rooted.count(o) > 0 || !visited.insert(o).second) continue;
+        if (context->trampoline_store.count(o) > 0) {
+          anchors.emplace_back(PyStrongRef(PyWeakRef(obj)), PyStrongRef(PyWeakRef(o)));
+        } else {
+          Traverse(o, VisitPush, &search);
+        }
+      }
+    });
+  }
+
+  // The JS part, everything above must be done without calling into V8
+  // as this could run the finalizers of the JS wrappers
+  for (auto const &anchor : anchors) {
+    PyObjectWrap **stored = context->object_store.find(*anchor.first);
+    if (stored == nullptr || (*stored)->Value().IsEmpty()) continue;
+    Object js = (*stored)->Value();
+    (*stored)->cycle_anchor = true;
+    auto trampoline = reinterpret_cast<JSCall_Trampoline *>(*anchor.second);
+    Function fn = trampoline->js_fn->Value();
+    if (fn.IsEmpty()) continue;
+
+    Array list;
+    if (js.HasOwnProperty("__pymport_cycles__")) {
+      list = js.Get("__pymport_cycles__").As<Array>();
+    } else {
+      list = Array::New(env);
+      js.DefineProperty(Napi::PropertyDescriptor::Value("__pymport_cycles__", list, napi_default));
+    }
+    bool present = false;
+    for (uint32_t i = 0; i < list.Length() && !present; i++) present = list.Get(i).StrictEquals(fn);
+    if (!present) list.Set(list.Length(), fn);
+
+    if (!trampoline->weak) {
+      VERBOSE_PYOBJ(CALL, *anchor.second, "jscall_trampoline weaken");
+      trampoline->js_fn->Unref();
+      trampoline->weak = true;
+      weakened++;
+    }
+  }
+
+  Object r = Object::New(env);
+  r.Set("weakened", Number::New(env, static_cast<double>(weakened)));
+  r.Set("strengthened", Number::New(env, static_cast<double>(strengthened)));
+  return r;
+}
+
+// A JS wrapper reaching a weak trampoline is about to expose its object to Python
+void PyObjectWrap::_CycleAnchorTouched(Napi::Env env) {
+  PyGILGuard pyGilGuard;
+  auto context = env.GetInstanceData<EnvContext>();
+  for (auto t : context->trampoline_store) {
+    auto trampoline = reinterpret_cast<JSCall_Trampoline *>(t);
+    if (trampoline->weak && !trampoline->js_fn->Value().IsEmpty()) {
+      VERBOSE_PYOBJ(CALL, t, "jscall_trampoline strengthen");
+      trampoline->js_fn->Ref();
+      trampoline->weak = false;
+    }
+  }
+}
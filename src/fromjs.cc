@@ -1,4 +1,6 @@
 #include <cmath>
+#include <cstring>
+#include <memory>
 #include "pymport.h"
 #include "pystackobject.h"
 #include "values.h"
@@ -10,13 +12,56 @@ Value PyObjectWrap::String(const CallbackInfo &info) {
   Napi::Env env = info.Env();
   PyGILGuard pyGilGuard;
 
-  auto raw = NAPI_ARG_STRING(0).Utf16Value();
-  PyStrongRef obj =
-    PyUnicode_DecodeUTF16(reinterpret_cast<const char *>(raw.c_str()), raw.size() * 2, nullptr, nullptr);
-  EXCEPTION_CHECK(env, obj);
+  PyStrongRef obj = _FromJS_String(NAPI_ARG_STRING(0));
   return New(env, std::move(obj));
 }
 
+// The Python string is created directly in its final representation
+// N-API cannot tell if a JS string is a one-byte string and napi_get_value_string_latin1()
+// silently truncates the other characters, so the string is read as UTF-16 - to a stack
+// buffer for short strings - and the widest character selects the kind of the Python string
+// (most strings are ASCII and become 1-byte strings without going through a UTF-16 decoder)
+// Only the strings that contain surrogate pairs need decoding
+PyStrongRef PyObjectWrap::_FromJS_String(Napi::Value v) {
+  Napi::Env env = v.Env();
+  size_t len;
+  napi_status status = napi_get_value_string_utf16(env, v, nullptr, 0, &len);
+  if (status != napi_ok) throw Error::New(env);
+
+  char16_t stack[256];
+  std::unique_ptr<char16_t[]> heap;
+  char16_t *raw = stack;
+  if (len >= sizeof(stack) / sizeof(stack[0])) {
+    heap.reset(new char16_t[len + 1]);
+    raw = heap.get();
+  }
+  status = napi_get_value_string_utf16(env, v, raw, len + 1, &len);
+  if (status != napi_ok) throw Error::New(env);
+
+  char16_t max = 0;
+  bool surrogates = false;
+  for (size_t i = 0; i < len; i++) {
+    if (raw[i] > max) max = raw[i];
+    if (raw[i] >= 0xD800 && raw[i] <= 0xDFFF) surrogates = true;
+  }
+
+  if (surrogates) {
+    PyStrongRef py = PyUnicode_DecodeUTF16(reinterpret_cast<const char *>(raw), len * 2, nullptr, nullptr);
+    EXCEPTION_CHECK(env, py);
+    return py;
+  }
+
+  PyStrongRef py = PyUnicode_New(static_cast<Py_ssize_t>(len), max);
+  EXCEPTION_CHECK(env, py);
+  if (PyUnicode_KIND(*py) == PyUnicode_1BYTE_KIND) {
+    Py_UCS1 *data = PyUnicode_1BYTE_DATA(*py);
+    for (size_t i = 0; i < len; i++) data[i] = static_cast<Py_UCS1>(raw[i]);
+  } else {
+    memcpy(PyUnicode_2BYTE_DATA(*py), raw, len * sizeof(char16_t));
+  }
+  return py;
+}
+
 Value PyObjectWrap::Float(const CallbackInfo &info) {
   Napi::Env env = info.Env();
   PyGILGuard pyGilGuard;
@@ -30,6 +75,7 @@ Value PyObjectWrap::Float(const CallbackInfo &info) {
   } else if (info[0].IsObject()) {
     Object raw = NAPI_ARG_PYOBJECT(0);
     PyObjectWrap *py = PyObjectWrap::Unwrap(raw);
+    py->Touch(env);
     PyStrongRef r = PyNumber_Float(*py->self);
     EXCEPTION_CHECK(env, r);
     return New(env, std::move(r));
@@ -54,6 +100,7 @@ Value PyObjectWrap::Integer(const CallbackInfo &info) {
   } else if (info[0].IsObject()) {
     Object raw = NAPI_ARG_PYOBJECT(0);
     PyObjectWrap *py = PyObjectWrap::Unwrap(raw);
+    py->Touch(env);
     PyStrongRef r = PyNumber_Long(*py->self);
     EXCEPTION_CHECK(env, r);
     return New(env, std::move(r));
@@ -70,12 +117,13 @@ void PyObjectWrap::_FromJS_Dictionary(Napi::Object object, const PyStrongRef &ta
   Napi::Env env = object.Env();
 
   for (auto const &el : object.GetPropertyNames()) {
-    auto key = ((Napi::Value)el.second).ToString().Utf8Value();
-    auto js = object.Get(key);
+    Napi::Value name = el.second;
+    PyWeakRef key = store.Key(name);
+    auto js = object.Get(name);
     PyStrongRef item = _FromJS(js, store);
     EXCEPTION_CHECK(env, item);
     // This is the only Py***_Set that does not steal a reference
-    int status = PyDict_SetItemString(*target, key.c_str(), *item);
+    int status = PyDict_SetItem(*target, *key, *item);
     EXCEPTION_CHECK(env, status);
   }
 }
@@ -93,17 +141,75 @@ Value PyObjectWrap::Dictionary(const CallbackInfo &info) {
   return New(env, std::move(dict));
 }
 
+// Reads the leading numbers of a JS array in a single pass
+// napi_get_value_double() checks the type and retrieves the value at the same time
+// Returns the number of elements read, the reading stops at the first non-number
+// (there is no batched element access in Node-API, every element is a separate call)
+size_t PyObjectWrap::_FromJS_ReadNumbers(Napi::Array array, size_t len, std::vector<double> &numbers) {
+  Napi::Env env = array.Env();
+  for (size_t i = 0; i < len; i++) {
+    napi_value el;
+    napi_status status = napi_get_element(env, array, static_cast<uint32_t>(i), &el);
+    if (status != napi_ok) throw Error::New(env);
+    double v;
+    status = napi_get_value_double(env, el, &v);
+    if (status == napi_number_expected) return i;
+    if (status != napi_ok) throw Error::New(env);
+    // Allocate only once the first element is known to be a number
+    if (i == 0) numbers.reserve(len);
+    numbers.push_back(v);
+  }
+  return len;
+}
+
 // Returns a strong reference
+// The leading numbers are read without going through the generic conversion,
+// the first non-number switches to it for the rest of the array
 void PyObjectWrap::_FromJS_List(Napi::Array array, const PyStrongRef &target, PyObjectStore &store) {
+  Napi::Env env = array.Env();
   size_t len = array.Length();
 
-  for (size_t i = 0; i < len; i++) {
+  std::vector<double> numbers;
+  size_t i = _FromJS_ReadNumbers(array, len, numbers);
+  for (size_t j = 0; j < i; j++) {
+    PyStrongRef el = _FromJS_Number(env, numbers[j]);
+    // The list is new and empty, this steals the reference
+    PyList_SET_ITEM(*target, j, el.gift());
+  }
+
+  for (; i < len; i++) {
     PyStrongRef el = _FromJS(array.Get(i), store);
     int status = PyList_SetItem(*target, i, el.gift());
     EXCEPTION_CHECK(array.Env(), status);
   }
 }
 
+// array.array('d') from a JS array of numbers, the values are read in a single pass
+// and copied at once into the array, the resulting object supports the buffer protocol (numpy.frombuffer)
+Value PyObjectWrap::NumberArray(const CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  PyGILGuard pyGilGuard;
+
+  Napi::Array array = NAPI_ARG_ARRAY(0);
+  size_t len = array.Length();
+  std::vector<double> numbers;
+  if (_FromJS_ReadNumbers(array, len, numbers) != len)
+    throw TypeError::New(env, "Argument must be an array of numbers");
+
+  PyStrongRef module = PyImport_ImportModule("array");
+  EXCEPTION_CHECK(env, module);
+  PyStrongRef r = PyObject_CallMethod(*module, "array", "s", "d");
+  EXCEPTION_CHECK(env, r);
+  if (len > 0) {
+    PyStrongRef raw =
+      PyMemoryView_FromMemory(reinterpret_cast<char *>(numbers.data()), len * sizeof(double), PyBUF_READ);
+    EXCEPTION_CHECK(env, raw);
+    PyStrongRef status = PyObject_CallMethod(*r, "frombytes", "O", *raw);
+    EXCEPTION_CHECK(env, status);
+  }
+  return New(env, std::move(r));
+}
+
 Value PyObjectWrap::List(const CallbackInfo &info) {
   Napi::Env env = info.Env();
   PyGILGuard pyGilGuard;
@@ -119,6 +225,7 @@ Value PyObjectWrap::List(const CallbackInfo &info) {
   } else {
     auto py = NAPI_ARG_PYOBJECT(0);
     PyObjectWrap *iterable = Unwrap(py);
+    iterable->Touch(env);
     PyStrongRef iter = PyObject_GetIter(*iterable->self);
     EXCEPTION_CHECK(env, iter);
     list = PyList_New(0);
@@ -161,6 +268,7 @@ Value PyObjectWrap::Tuple(const CallbackInfo &info) {
   } else {
     auto py = NAPI_ARG_PYOBJECT(0);
     PyObjectWrap *list = Unwrap(py);
+    list->Touch(env);
     if (!PyList_Check(*list->self)) { throw TypeError::New(env, "PyObject is not a list"); }
     tuple = PyList_AsTuple(*list->self);
     EXCEPTION_CHECK(env, tuple);
@@ -193,6 +301,7 @@ Value PyObjectWrap::Set(const CallbackInfo &info) {
   } else {
     Object py = NAPI_ARG_PYOBJECT(0);
     PyObjectWrap *iterable = Unwrap(py);
+    iterable->Touch(env);
     set = PySet_New(*iterable->self);
     EXCEPTION_CHECK(env, set);
   }
@@ -214,6 +323,7 @@ Value PyObjectWrap::FrozenSet(const CallbackInfo &info) {
   } else {
     Object py = NAPI_ARG_PYOBJECT(0);
     PyObjectWrap *iterable = Unwrap(py);
+    iterable->Touch(env);
     set = PyFrozenSet_New(*iterable->self);
     EXCEPTION_CHECK(env, set);
   }
@@ -292,35 +402,73 @@ static bool HasPrototype(Napi::Object v) {
   return !proto_proto.IsNull();
 }
 
-// Returns a strong reference
-PyStrongRef PyObjectWrap::_FromJS(Napi::Value v, PyObjectStore &store) {
+// Napi::Values cannot be hashed and must be individually compared
+// using the provided operator==, so the identity map is a JS Map
+// that maps the objects to their index in the objects vector
+// It is created only when the first container is encountered,
+// converting scalars does not require it
+PyWeakRef PyObjectWrap::PyObjectStore::Find(Napi::Value v) {
+  if (map.IsEmpty()) return nullptr;
+  auto context = v.Env().GetInstanceData<EnvContext>();
+  Napi::Value idx = context->js_map.get->Call(map, {v});
+  if (!idx.IsNumber()) return nullptr;
+  return objects[idx.As<Number>().Uint32Value()];
+}
+
+void PyObjectWrap::PyObjectStore::Insert(Napi::Value v, const PyWeakRef &py) {
   Napi::Env env = v.Env();
+  auto context = env.GetInstanceData<EnvContext>();
+  if (map.IsEmpty()) map = context->js_map.cons->New({});
+  context->js_map.set->Call(map, {v, Number::New(env, static_cast<double>(objects.size()))});
+  objects.push_back(py);
+}
 
-  // Break recursion on circular references
-  // Alas, Napi::Values must be individually compared using
-  // the provided operator==...
-  for (const auto &i : store) {
-    if (i.first == v) {
-      // The store contains weak references
-      // We must return a strong reference
-      return PyStrongRef(i.second);
-    }
+// Returns a strong reference
+// A number without a decimal part becomes an int
+PyStrongRef PyObjectWrap::_FromJS_Number(Napi::Env env, double raw) {
+  double integer;
+  double fract = fabs(modf(raw, &integer));
+  PyStrongRef py = nullptr;
+  if ((fract < std::numeric_limits<float>::epsilon() || fract > 1 - std::numeric_limits<float>::epsilon()) &&
+      !std::isinf(raw)) {
+    // Outside of this range the cast is undefined
+    if (raw > -9.2e18 && raw < 9.2e18)
+      py = PyLong_FromLongLong(static_cast<long long>(raw));
+    else
+      py = PyLong_FromDouble(raw);
+  } else {
+    py = PyFloat_FromDouble(raw);
   }
+  EXCEPTION_CHECK(env, py);
+  return py;
+}
 
-  if (v.IsNumber()) {
-    double raw = v.ToNumber().DoubleValue();
-    double integer;
-    double fract = fabs(modf(raw, &integer));
-    PyStrongRef py = nullptr;
-    if (
-      (fract < std::numeric_limits<float>::epsilon() || fract > 1 - std::numeric_limits<float>::epsilon()) &&
-      !std::isinf(raw))
-      py = PyLong_FromLongLong(static_cast<long long>(v.ToNumber().Int64Value()));
-    else
-      py = PyFloat_FromDouble(raw);
-    EXCEPTION_CHECK(env, py);
-    return py;
+// Property names are usually repeated across the objects of a conversion,
+// each one is converted only once to an interned Python string
+// (interned strings also have their hash precomputed for PyDict_SetItem)
+// The store keeps the strong references until the end of the conversion
+PyWeakRef PyObjectWrap::PyObjectStore::Key(Napi::Value name) {
+  Napi::Env env = name.Env();
+  auto context = env.GetInstanceData<EnvContext>();
+  if (key_map.IsEmpty()) {
+    key_map = context->js_map.cons->New({});
+  } else {
+    Napi::Value idx = context->js_map.get->Call(key_map, {name});
+    if (idx.IsNumber()) return keys[idx.As<Number>().Uint32Value()];
   }
+
+  PyObject *key = _FromJS_String(name).gift();
+  PyUnicode_InternInPlace(&key);
+  context->js_map.set->Call(key_map, {name, Number::New(env, static_cast<double>(keys.size()))});
+  keys.emplace_back(key);
+  return keys.back();
+}
+
+// Returns a strong reference
+PyStrongRef PyObjectWrap::_FromJS(Napi::Value v, PyObjectStore &store) {
+  Napi::Env env = v.Env();
+
+  if (v.IsNumber()) { return _FromJS_Number(env, v.As<Number>().DoubleValue()); }
   if (v.IsBigInt()) {
     bool lossless;
     int64_t raw = v.As<BigInt>().Int64Value(&lossless);
@@ -329,19 +477,22 @@ PyStrongRef PyObjectWrap::_FromJS(Napi::Value v, PyObjectStore &store) {
     EXCEPTION_CHECK(env, py);
     return py;
   }
-  if (v.IsString()) {
-    auto raw = v.ToString().Utf16Value();
-    PyStrongRef py =
-      PyUnicode_DecodeUTF16(reinterpret_cast<const char *>(raw.c_str()), raw.size() * 2, nullptr, nullptr);
-    EXCEPTION_CHECK(env, py);
-    store.push_front({v, py});
-    return py;
+  if (v.IsString()) { return _FromJS_String(v); }
+
+  // Break recursion on circular references
+  // Only objects are stored, primitive values cannot be circular
+  if (v.IsObject()) {
+    PyWeakRef existing = store.Find(v);
+    // The store contains weak references
+    // We must return a strong reference
+    if (existing != nullptr) return PyStrongRef(existing);
   }
+
   if (v.IsArray()) {
     auto array = v.As<Array>();
     PyStrongRef list = PyList_New(array.Length());
     EXCEPTION_CHECK(env, list);
-    store.push_front({v, list});
+    store.Insert(v, list);
     _FromJS_List(array, list, store);
     return list;
   }
@@ -350,6 +501,7 @@ PyStrongRef PyObjectWrap::_FromJS(Napi::Value v, PyObjectStore &store) {
     if (_FunctionOf(obj)) {
       auto wrap = obj.Get("__PyObject__").ToObject();
       auto py = ObjectWrap::Unwrap(wrap);
+      py->Touch(v.Env());
       // Copy the strong reference
       return PyStrongRef(py->self);
     }
@@ -357,11 +509,13 @@ PyStrongRef PyObjectWrap::_FromJS(Napi::Value v, PyObjectStore &store) {
     // must come after the previous block
     if (_InstanceOf(obj)) {
       auto py = ObjectWrap::Unwrap(obj);
+      py->Touch(v.Env());
       // Copy the strong reference
       return PyStrongRef(py->self);
     }
 
     if (v.IsBuffer()) { return _FromJS_BytesArray(v.As<Buffer<char>>()); }
+    if (v.IsTypedArray() || v.IsDataView() || v.IsArrayBuffer()) { return _FromJS_TypedArray(v); }
     if (v.IsFunction()) { return NewJSFunction(v.As<Function>()); }
 
     // These are not supported
@@ -370,7 +524,7 @@ PyStrongRef PyObjectWrap::_FromJS(Napi::Value v, PyObjectStore &store) {
     // Fallback to dictionary
     PyStrongRef dict = PyDict_New();
     EXCEPTION_CHECK(env, dict);
-    store.push_front({v, dict});
+    store.Insert(v, dict);
     _FromJS_Dictionary(obj, dict, store);
     return dict;
   }
@@ -0,0 +1,210 @@
+#include <vector>
+#include <memory>
+
+#include "pymport.h"
+#include "pystackobject.h"
+#include "values.h"
+
+using namespace Napi;
+using namespace pymport;
+
+// Deferred expression graphs - pymport.lazy()
+//
+// lib/index.js records the operations on a lazy expression and sends the whole graph
+// when its value is forced. The graph is an array of nodes in topological order,
+// the last one is the result:
+// [0, value]                              a value
+// [1, obj, name]                          obj.name
+// [2, obj, key, key_node]                 obj[key], key_node is the node of the key or -1
+// [3, fn, args, arg_nodes, kwnames]       fn(...args), arg_nodes contains the node of each
+//                                         argument or -1, the last arguments are named
+//                                         arguments if kwnames is present
+//
+// The JS values are converted on the V8 main thread, the graph can then be executed
+// in any thread with a single GIL acquisition. Only the result is wrapped.
+// The call of an attribute that is not used elsewhere is fused into a method call.
+
+struct PyObjectWrap::GraphNode {
+  enum Op { VALUE = 0, GET = 1, ITEM = 2, CALL = 3, METHOD = 4 };
+  Op op;
+  int32_t obj;
+  int32_t key_node;
+  // VALUE: the value, GET/METHOD: the name, ITEM: the key
+  PyStrongRef value;
+  // CALL/METHOD: the arguments, arg_nodes are the slots that receive the results of other nodes
+  std::unique_ptr<VectorcallArgs> args;
+  std::vector<std::pair<size_t, int32_t>> arg_nodes;
+  uint32_t uses;
+
+  GraphNode(Op op) : op(op), obj(-1), key_node(-1), value(nullptr), uses(0) {
+  }
+};
+
+// Must be destroyed with the GIL held
+struct PyObjectWrap::Graph {
+  std::vector<std::unique_ptr<GraphNode>> nodes;
+};
+
+// Reference to a previous node
+static int32_t GraphRef(Napi::Env env, Napi::Value v, size_t current) {
+  if (!v.IsNumber()) throw TypeError::New(env, "Invalid expression graph");
+  int32_t idx = v.As<Number>().Int32Value();
+  if (idx < 0 || static_cast<size_t>(idx) >= current) throw TypeError::New(env, "Invalid expression graph");
+  return idx;
+}
+
+// Must be called on the V8 main thread with the GIL held
+std::shared_ptr<PyObjectWrap::Graph> PyObjectWrap::_CompileGraph(Napi::Env env, Napi::Array js) {
+  auto graph = std::make_shared<Graph>();
+  size_t len = js.Length();
+  if (len == 0) throw TypeError::New(env, "Invalid expression graph");
+  graph->nodes.reserve(len);
+
+  for (size_t i = 0; i < len; i++) {
+    HandleScope scope(env);
+    Napi::Value el = js.Get(static_cast<uint32_t>(i));
+    if (!el.IsArray()) throw TypeError::New(env, "Invalid expression graph");
+    Array desc = el.As<Array>();
+    int32_t op = desc.Get(0u).ToNumber().Int32Value();
+    if (op < GraphNode::VALUE || op > GraphNode::CALL) throw TypeError::New(env, "Invalid expression graph");
+    auto node = std::make_unique<GraphNode>(static_cast<GraphNode::Op>(op));
+
+    switch (node->op) {
+      case GraphNode::VALUE:
+        node->value = FromJS(desc.Get(1u));
+        EXCEPTION_CHECK(env, node->value);
+        break;
+      case GraphNode::GET:
+        node->obj = GraphRef(env, desc.Get(1u), i);
+        // The names live as long as the graph, they are not added to the method name cache
+        node->value = _AttrName(env, desc.Get(2u));
+        break;
+      case GraphNode::ITEM:
+        node->obj = GraphRef(env, desc.Get(1u), i);
+        if (desc.Get(3u).ToNumber().Int32Value() >= 0) {
+          node->key_node = GraphRef(env, desc.Get(3u), i);
+          graph->nodes[node->key_node]->uses++;
+        } else {
+          node->value = FromJS(desc.Get(2u));
+          EXCEPTION_CHECK(env, node->value);
+        }
+        break;
+      case GraphNode::CALL: {
+        node->obj = GraphRef(env, desc.Get(1u), i);
+        Napi::Value js_args = desc.Get(2u), js_nodes = desc.Get(3u), js_kwnames = desc.Get(4u);
+        if (!js_args.IsArray() || !js_nodes.IsArray()) throw TypeError::New(env, "Invalid expression graph");
+        Array args = js_args.As<Array>(), arg_nodes = js_nodes.As<Array>();
+        size_t argc = args.Length();
+        size_t nkw = js_kwnames.IsArray() ? js_kwnames.As<Array>().Length() : 0;
+        if (nkw > argc || arg_nodes.Length() != argc) throw TypeError::New(env, "Invalid expression graph");
+
+        node->args = std::make_unique<VectorcallArgs>();
+        node->args->Reserve(argc);
+        for (size_t j = 0; j < argc; j++) {
+          Napi::Value ref = arg_nodes.Get(static_cast<uint32_t>(j));
+          if (ref.ToNumber().Int32Value() >= 0) {
+            int32_t idx = GraphRef(env, ref, i);
+            graph->nodes[idx]->uses++;
+            node->arg_nodes.emplace_back(node->args->Placeholder(), idx);
+          } else {
+            PyStrongRef v = FromJS(args.Get(static_cast<uint32_t>(j)));
+            EXCEPTION_CHECK(env, v);
+            node->args->Push(std::move(v));
+          }
+        }
+        node->args->nargs = argc - nkw;
+
+        if (nkw > 0) {
+          Array kwnames = js_kwnames.As<Array>();
+          node->args->kwnames = PyTuple_New(nkw);
+          EXCEPTION_CHECK(env, node->args->kwnames);
+          for (size_t j = 0; j < nkw; j++) {
+            PyStrongRef name = _AttrName(env, kwnames.Get(static_cast<uint32_t>(j)));
+            PyTuple_SET_ITEM(*node->args->kwnames, j, name.gift());
+          }
+        }
+
+        break;
+      }
+      default:
+        break;
+    }
+    if (node->obj >= 0) graph->nodes[node->obj]->uses++;
+    graph->nodes.push_back(std::move(node));
+  }
+
+  // Fuse obj.name(...) into a method call when obj.name is not used elsewhere
+  for (auto &node : graph->nodes) {
+    if (node->op != GraphNode::CALL) continue;
+    GraphNode &fn = *graph->nodes[node->obj];
+    if (fn.op != GraphNode::GET || fn.uses != 1) continue;
+    node->op = GraphNode::METHOD;
+    node->obj = fn.obj;
+    node->value = std::move(fn.value);
+    fn.uses = 0;
+  }
+
+  return graph;
+}
+
+// Must be called with the GIL held, can run in any thread
+// Returns nullptr and leaves the Python error set if an operation fails
+PyStrongRef PyObjectWrap::_RunGraph(Graph &graph) {
+  size_t len = graph.nodes.size();
+  // Strong references to the intermediate results
+  std::vector<PyObject *> results(len, nullptr);
+
+  for (size_t i = 0; i < len; i++) {
+    GraphNode &node = *graph.nodes[i];
+    // The fused attributes
+    if (node.uses == 0 && i != len - 1) continue;
+
+    PyObject *r = nullptr;
+    switch (node.op) {
+      case GraphNode::VALUE:
+        r = *node.value;
+        Py_INCREF(r);
+        break;
+      case GraphNode::GET:
+        r = PyObject_GetAttr(results[node.obj], *node.value);
+        break;
+      case GraphNode::ITEM:
+        r = PyObject_GetItem(results[node.obj], node.key_node >= 0 ? results[node.key_node] : *node.value);
+        break;
+      case GraphNode::CALL:
+      case GraphNode::METHOD: {
+        VectorcallArgs &call = *node.args;
+        for (auto const &slot : node.arg_nodes) {
+          Py_XDECREF(call.args[slot.first]);
+          Py_INCREF(results[slot.second]);
+          call.args[slot.first] = results[slot.second];
+        }
+        if (node.op == GraphNode::CALL) {
+          r = PyObject_Vectorcall(
+            results[node.obj], call.args + 1, call.nargs | PY_VECTORCALL_ARGUMENTS_OFFSET, *call.kwnames);
+        } else {
+          r = _VectorcallMethod(results[node.obj], node.value, call).gift();
+        }
+        break;
+      }
+    }
+    if (r == nullptr) break;
+    results[i] = r;
+  }
+
+  PyStrongRef r = results[len - 1];
+  results[len - 1] = nullptr;
+  for (PyObject *py : results) Py_XDECREF(py);
+  return r;
+}
+
+// Synchronous execution of an expression graph
+Value PyObjectWrap::RunGraph(const CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  Array nodes = NAPI_ARG_ARRAY(0);
+  PyGILGuard pyGilGuard;
+  auto graph = _CompileGraph(env, nodes);
+  PyStrongRef r = _RunGraph(*graph);
+  EXCEPTION_CHECK(env, r);
+  return New(env, std::move(r));
+}
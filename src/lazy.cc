@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <string>
+
+#include "pymport.h"
+#include "pystackobject.h"
+#include "values.h"
+#include "release.h"
+
+using namespace Napi;
+using namespace pymport;
+
+// Lazy conversion - toJS({lazy: true})
+//
+// Lists, tuples and dictionaries with string keys become Proxies over an empty
+// Array or Object that serves as a cache:
+// * an element is converted when it is accessed for the first time and it is
+//   stored in the cache, the containers are converted lazily too
+// * the length and the keys come directly from Python, without converting the elements
+// * every other container (sets, modules...) and every scalar is converted eagerly
+//
+// The Proxy is a snapshot of the element values at the time of their first access,
+// the identity of the shared references is not preserved
+
+// The Python container of a cache object (attached with napi_wrap)
+struct LazyData {
+  PyObject *py;
+  ToJSOpts opts;
+};
+
+static void Lazy_Finalizer(napi_env, void *data, void *) {
+  auto lazy = static_cast<LazyData *>(data);
+  // Skip if Python has been shut down, refer to PyObjectWrap::Finalize
+  if (active_environments > 0) {
+    if (release::background) {
+      release::Enqueue(lazy->py);
+    } else {
+      PyGILGuard pyGilGuard;
+      Py_DECREF(lazy->py);
+    }
+  }
+  delete lazy;
+}
+
+static LazyData *LazyUnwrap(Napi::Env env, Napi::Value target) {
+  void *data;
+  napi_status status = napi_unwrap(env, target, &data);
+  if (status != napi_ok) throw Error::New(env);
+  return static_cast<LazyData *>(data);
+}
+
+static inline bool IsLazyArray(PyObject *py) {
+  return PyList_Check(py) || PyTuple_Check(py);
+}
+
+// Only the dictionaries with string keys can be looked up by property name
+static bool IsLazyDictionary(PyObject *py) {
+  if (!PyDict_Check(py)) return false;
+  PyObject *key, *value;
+  Py_ssize_t pos = 0;
+  while (PyDict_Next(py, &pos, &key, &value))
+    if (!PyUnicode_Check(key)) return false;
+  return true;
+}
+
+static Py_ssize_t LazyLength(PyObject *py) {
+  return PyList_Check(py) ? PyList_GET_SIZE(py) : PyTuple_GET_SIZE(py);
+}
+
+// Canonical array indices only ("1" but not "01" or "1.0")
+static bool ParseIndex(const std::string &prop, Py_ssize_t &idx) {
+  if (prop.empty() || prop.size() > 15 || (prop[0] == '0' && prop.size() > 1)) return false;
+  idx = 0;
+  for (char c : prop) {
+    if (c < '0' || c > '9') return false;
+    idx = idx * 10 + (c - '0');
+  }
+  return true;
+}
+
+// Returns a borrowed reference or nullptr
+PyWeakRef PyObjectWrap::_LazyFind(Napi::Env env, Napi::Value target, Napi::Value prop) {
+  if (!prop.IsString()) return nullptr;
+  LazyData *lazy = LazyUnwrap(env, target);
+
+  if (IsLazyArray(lazy->py)) {
+    Py_ssize_t idx;
+    if (!ParseIndex(prop.As<Napi::String>().Utf8Value(), idx)) return nullptr;
+    uint32_t len = target.As<Napi::Array>().Length();
+    if (idx >= std::min(static_cast<Py_ssize_t>(len), LazyLength(lazy->py))) return nullptr;
+    return PyList_Check(lazy->py) ? PyList_GET_ITEM(lazy->py, idx) : PyTuple_GET_ITEM(lazy->py, idx);
+  }
+
+  PyStrongRef key = _FromJS_String(prop);
+  PyWeakRef r = PyDict_GetItemWithError(lazy->py, *key);
+  if (r == nullptr) PyErr_Clear();
+  return r;
+}
+
+// Converts and caches an element, returns an empty value if it does not exist
+Napi::Value PyObjectWrap::_LazyElement(Napi::Env env, Napi::Object target, Napi::Value prop) {
+  PyWeakRef py = _LazyFind(env, target, prop);
+  if (py == nullptr) return Napi::Value();
+  // Keep it alive, the conversion can run Python code
+  PyStrongRef element(py);
+
+  ToJSOpts opts = LazyUnwrap(env, target)->opts;
+  Napi::Value r = _ToJS_Lazy(env, element, opts);
+  // An assignment of __proto__ would replace the prototype
+  target.DefineProperty(Napi::PropertyDescriptor::Value(prop.As<Name>(), r, napi_default_jsproperty));
+  return r;
+}
+
+Value PyObjectWrap::LazyGet(const CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  Object target = info[0].As<Object>();
+  Napi::Value prop = info[1];
+
+  if (prop.IsString() && !target.HasOwnProperty(prop)) {
+    PyGILGuard pyGilGuard;
+    Napi::Value r = _LazyElement(env, target, prop);
+    if (!r.IsEmpty()) return r;
+  }
+  // The cached elements, the length of the arrays and the prototype
+  return target.Get(prop);
+}
+
+Value PyObjectWrap::LazyHas(const CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  Object target = info[0].As<Object>();
+  Napi::Value prop = info[1];
+
+  if (target.Has(prop)) return Boolean::New(env, true);
+  PyGILGuard pyGilGuard;
+  return Boolean::New(env, _LazyFind(env, target, prop) != nullptr);
+}
+
+Value PyObjectWrap::LazyOwnKeys(const CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  Object target = info[0].As<Object>();
+  PyGILGuard pyGilGuard;
+  LazyData *lazy = LazyUnwrap(env, target);
+
+  Napi::Array keys = Napi::Array::New(env);
+  uint32_t i = 0;
+  if (IsLazyArray(lazy->py)) {
+    uint32_t len = std::min(target.As<Napi::Array>().Length(), static_cast<uint32_t>(LazyLength(lazy->py)));
+    for (; i < len; i++) keys.Set(i, Napi::String::New(env, std::to_string(i)));
+    // length is a non-configurable property of the target, it must be reported
+    keys.Set(i, Napi::String::New(env, "length"));
+  } else {
+    PyObject *key, *value;
+    Py_ssize_t pos = 0;
+    while (PyDict_Next(lazy->py, &pos, &key, &value)) keys.Set(i++, _ToJS_String(env, key));
+  }
+  return keys;
+}
+
+// Object.keys(), the spread operator and JSON.stringify() call this for every key, so
+// the enumeration converts one full level (the nested containers are still Proxies)
+// The descriptor cannot omit the value - ToPropertyDescriptor would complete it with
+// undefined - and an accessor descriptor would misreport the element as a getter
+Value PyObjectWrap::LazyGetOwnPropertyDescriptor(const CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  Object target = info[0].As<Object>();
+  Napi::Value prop = info[1];
+
+  Napi::Value value;
+  bool length = target.IsArray() && prop.IsString() && prop.As<Napi::String>().Utf8Value() == "length";
+  if (target.HasOwnProperty(prop)) {
+    value = target.Get(prop);
+  } else {
+    PyGILGuard pyGilGuard;
+    value = _LazyElement(env, target, prop);
+    if (value.IsEmpty()) return env.Undefined();
+  }
+
+  // The elements are stored in the cache as plain data properties
+  Object descriptor = Object::New(env);
+  descriptor.Set("value", value);
+  descriptor.Set("writable", Boolean::New(env, true));
+  descriptor.Set("enumerable", Boolean::New(env, !length));
+  descriptor.Set("configurable", Boolean::New(env, !length));
+  return descriptor;
+}
+
+Napi::Value PyObjectWrap::_ToJS_Lazy(Napi::Env env, const PyWeakRef &py, ToJSOpts opts) {
+  if (opts.depth == 0 || (!IsLazyArray(*py) && !IsLazyDictionary(*py))) return ToJS(env, py, opts);
+
+  auto context = env.GetInstanceData<EnvContext>();
+  if (context->lazy_handler == nullptr) {
+    Object handler = Object::New(env);
+    handler.Set("get", Function::New(env, LazyGet, "get"));
+    handler.Set("has", Function::New(env, LazyHas, "has"));
+    handler.Set("ownKeys", Function::New(env, LazyOwnKeys, "ownKeys"));
+    handler.Set(
+      "getOwnPropertyDescriptor", Function::New(env, LazyGetOwnPropertyDescriptor, "getOwnPropertyDescriptor"));
+    context->lazy_handler = new ObjectReference(Persistent(handler));
+  }
+
+  Object target;
+  if (IsLazyArray(*py))
+    target = Napi::Array::New(env, LazyLength(*py));
+  else
+    target = Object::New(env);
+
+  // The cache holds a strong reference that is released by the finalizer
+  auto lazy = new LazyData{*py, {opts.depth - 1, opts.buffer, opts.shared}};
+  Py_INCREF(*py);
+  napi_status status = napi_wrap(env, target, lazy, Lazy_Finalizer, nullptr, nullptr);
+  if (status != napi_ok) {
+    Py_DECREF(*py);
+    delete lazy;
+    throw Error::New(env);
+  }
+
+  return context->proxy->New({target, context->lazy_handler->Value()});
+}
@@ -7,6 +7,8 @@
 #include "pymport.h"
 #include "values.h"
 #include "memview.h"
+#include "release.h"
+#include "memory.h"
 
 #define _SILENCE_CXX17_CODECVT_HEADER_DEPRECATION_WARNING
 
@@ -73,6 +75,55 @@ Value Version(const CallbackInfo &info) {
   return versionInfo;
 }
 
+Value BackgroundRelease(const CallbackInfo &info) {
+  Env env = info.Env();
+  if (info.Length() < 1 || !info[0].IsBoolean()) throw TypeError::New(env, "Argument must be a boolean");
+  release::background = info[0].ToBoolean().Value();
+  return env.Undefined();
+}
+
+Value ReleaseStats(const CallbackInfo &info) {
+  Env env = info.Env();
+  auto stats = release::GetStats();
+  Object r = Object::New(env);
+
+  r.Set("enabled", Boolean::New(env, release::background));
+  r.Set("depth", Number::New(env, static_cast<double>(stats.depth)));
+  r.Set("released", Number::New(env, static_cast<double>(stats.released)));
+  r.Set("batches", Number::New(env, static_cast<double>(stats.batches)));
+  r.Set("lastDrainTime", Number::New(env, static_cast<double>(stats.last_drain_us) / 1000));
+  r.Set("maxDrainTime", Number::New(env, static_cast<double>(stats.max_drain_us) / 1000));
+
+  return r;
+}
+
+Value MemoryAccounting(const CallbackInfo &info) {
+  Env env = info.Env();
+  PyGILGuard pyGilGuard;
+
+  std::string mode = NAPI_ARG_STRING(0).Utf8Value();
+  if (mode == "estimate") {
+    memory::mode = memory::ESTIMATE;
+  } else if (mode == "tracemalloc") {
+    memory::EnableTraceMalloc();
+    if (PyErr_Occurred()) {
+      PythonException err
+#ifdef DEBUG
+        (LINEINFO)
+#endif
+          ;
+      throw err.ToJS(env);
+    }
+    memory::mode = memory::TRACEMALLOC;
+  } else {
+    throw RangeError::New(env, "Memory accounting mode must be \"estimate\" or \"tracemalloc\"");
+  }
+  // Report (or drop) the Python heap now
+  PyObjectWrap::SampleTracedMemory(env);
+
+  return env.Undefined();
+}
+
 // Runs the queue of V8 tasks scheduled from Python contexts
 static void RunInV8Context(uv_async_t *async) {
   auto context = reinterpret_cast<EnvContext *>(async->data);
@@ -119,12 +170,33 @@ static Napi::Object PympInit(Env env, Object exports) {
   exports.Set("PyObject", pyObjCons);
   exports.Set("pymport", Function::New(env, PyObjectWrap::Import));
   exports.Set("pyval", Function::New(env, PyObjectWrap::Eval));
+  exports.Set("backgroundRelease", Function::New(env, BackgroundRelease));
+  exports.Set("releaseStats", Function::New(env, ReleaseStats));
+  exports.Set("memoryAccounting", Function::New(env, MemoryAccounting));
+  exports.Set("collectCycles", Function::New(env, PyObjectWrap::CollectCycles));
+  exports.Set("memoCache", Function::New(env, PyObjectWrap::MemoCache));
+  exports.Set("memoStats", Function::New(env, PyObjectWrap::MemoStats));
+  exports.Set("asyncCallStats", Function::New(env, PyObjectWrap::AsyncCallStats));
+  // Internal, used by proxify() in lib/index.js
+  exports.Set("getMember", Function::New(env, PyObjectWrap::GetMember));
+  // Internal, used by pymport.lazy() in lib/index.js
+  exports.Set("runGraph", Function::New(env, PyObjectWrap::RunGraph));
+  exports.Set("runGraphAsync", Function::New(env, PyObjectWrap::RunGraphAsync));
   exports.DefineProperty(PropertyDescriptor::Accessor<Version>("version", napi_enumerable));
 
   auto context = new EnvContext();
   context->pyObj = new FunctionReference();
   *context->pyObj = Persistent(pyObjCons);
+  Function mapCons = env.Global().Get("Map").As<Function>();
+  Object mapProto = mapCons.Get("prototype").ToObject();
+  context->js_map.cons = new FunctionReference(Persistent(mapCons));
+  context->js_map.get = new FunctionReference(Persistent(mapProto.Get("get").As<Function>()));
+  context->js_map.set = new FunctionReference(Persistent(mapProto.Get("set").As<Function>()));
+  Function bufferCons = env.Global().Get("Buffer").As<Function>();
+  context->buffer_from = new FunctionReference(Persistent(bufferCons.Get("from").As<Function>()));
+  context->proxy = new FunctionReference(Persistent(env.Global().Get("Proxy").As<Function>()));
   context->v8_main = std::this_thread::get_id();
+  context->env = env;
   context->v8_queue.handle = new uv_async_t;
 
   uv_loop_t *event_loop;
@@ -134,6 +206,13 @@ static Napi::Object PympInit(Env env, Object exports) {
     throw Error::New(env, "Failed initializing libuv queue");
   uv_unref(reinterpret_cast<uv_handle_t *>(context->v8_queue.handle));
   context->v8_queue.handle->data = context;
+  context->js_async.handle = new uv_async_t;
+  context->js_async.env = env;
+  context->js_async.closed = false;
+  if (uv_async_init(event_loop, context->js_async.handle, PyObjectWrap::RunJSAsyncCalls) != 0)
+    throw Error::New(env, "Failed initializing libuv queue");
+  uv_unref(reinterpret_cast<uv_handle_t *>(context->js_async.handle));
+  context->js_async.handle->data = context;
   VERBOSE(
     INIT,
     "PyGIL: Initialized new environment, V8 main thread is %lu\n",
@@ -153,11 +232,33 @@ static Napi::Object PympInit(Env env, Object exports) {
       active_environments--;
       context->pyObj->Reset();
       delete context->pyObj;
+      for (auto ref :
+           {context->js_map.cons, context->js_map.get, context->js_map.set, context->buffer_from, context->proxy}) {
+        ref->Reset();
+        delete ref;
+      }
+      if (context->lazy_handler != nullptr) {
+        context->lazy_handler->Reset();
+        delete context->lazy_handler;
+      }
 
       // release all TSFNs (destruction path 2)
       for (auto const &tsfn : context->tsfn_store) { tsfn->Release(); }
       context->tsfn_store.clear();
 
+      // The pending fire-and-forget calls are dropped
+      // and the memoized conversions and the interned names release their Python objects
+      {
+        PyGILGuard pyGilGuard;
+        PyObjectWrap::CloseJSAsyncCalls(context);
+        context->memo.enabled = false;
+        PyObjectWrap::MemoClear(context->env, context);
+        context->method_names.clear();
+      }
+      uv_close(reinterpret_cast<uv_handle_t *>(context->js_async.handle), [](uv_handle_t *handle) {
+        delete reinterpret_cast<uv_async_t *>(handle);
+      });
+
       // abuse the data pointer to send the async hook
       context->v8_queue.handle->data = hook;
       uv_close(reinterpret_cast<uv_handle_t *>(context->v8_queue.handle), [](uv_handle_t *handle) {
@@ -180,6 +281,7 @@ static Napi::Object PympInit(Env env, Object exports) {
       // https://github.com/nodejs/node/issues/45088
       if (active_environments == 0) {
         VERBOSE(INIT, "Shutting down Python\n");
+        release::Shutdown();
         PyEval_RestoreThread(py_main);
         Py_Finalize();
       }
@@ -222,7 +324,9 @@ static Napi::Object PympInit(Env env, Object exports) {
       throw Error::New(env, "Failed initializing Python: "s + std::string{status.err_msg});
     }
     memview::Init();
+    memory::Init();
     PyObjectWrap::InitJSTrampoline();
+    release::Init();
     py_main = PyEval_SaveThread();
   }
   active_environments++;
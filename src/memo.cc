@@ -0,0 +1,138 @@
+#include <vector>
+
+#include "pymport.h"
+#include "pystackobject.h"
+#include "values.h"
+#include "release.h"
+
+using namespace Napi;
+using namespace pymport;
+
+// Memoization of the conversion of the immutable objects - memoCache()
+//
+// When enabled, the conversions of the tuples and the frozensets that contain only immutable
+// values (None, bool, int, float, str and other such tuples and frozensets) are cached:
+// * the cache holds a strong reference to the Python object, so that its address cannot be
+//   reused, and a weak reference to the JS array
+// * the arrays are frozen, they are shared by all the conversions of the same object
+// * when V8 collects the array, its finalizer removes the entry and releases the Python object
+//
+// The immutability is established by the conversion itself (tojs.cc) - every tuple and
+// frozenset frame starts as immutable, it becomes mutable when one of its elements is not
+// immutable, and a mutable frame makes its parent mutable when it is complete - there is
+// no separate walk of the object.
+//
+// The scalars are not cached - they are JS primitives that cannot be weakly referenced and
+// their conversion costs less than the lookup. The bytes are not cached either - they become
+// mutable Buffers.
+
+// Called by V8 when the memoized array is garbage-collected
+static void Memo_Finalizer(napi_env env, void *data, void *hint) {
+  // Skip if Python has been shut down, refer to PyObjectWrap::Finalize
+  if (active_environments == 0) return;
+  auto py = static_cast<PyObject *>(data);
+  auto ref = static_cast<napi_ref>(hint);
+  auto context = Napi::Env(env).GetInstanceData<EnvContext>();
+
+  // The entry can be gone (the cache was disabled) or it can already
+  // point to a newer conversion of the same object
+  napi_ref *entry = context->memo.entries.find(py);
+  if (entry == nullptr || *entry != ref) return;
+  context->memo.entries.erase(py);
+  napi_delete_reference(env, ref);
+
+  if (release::background) {
+    release::Enqueue(py);
+    return;
+  }
+  PyGILGuard pyGilGuard;
+  Py_DECREF(py);
+}
+
+// True if an element that has been converted does not prevent the memoization of its container
+// The immutable containers have already been memoized when they were completed
+bool PyObjectWrap::_ToJS_MemoElement(Napi::Env env, const PyWeakRef &py) {
+  if (*py == Py_None || PyLong_Check(*py) || PyFloat_Check(*py) || PyUnicode_Check(*py)) return true;
+  auto context = env.GetInstanceData<EnvContext>();
+  return context->memo.entries.find(*py) != nullptr;
+}
+
+// Returns an empty value when the object has not been memoized
+Napi::Value PyObjectWrap::_ToJS_MemoFind(Napi::Env env, const PyWeakRef &py) {
+  auto context = env.GetInstanceData<EnvContext>();
+  napi_ref *entry = context->memo.entries.find(*py);
+  if (entry == nullptr) return Napi::Value();
+
+  napi_value cached;
+  napi_status status = napi_get_reference_value(env, *entry, &cached);
+  if (status != napi_ok) throw Error::New(env);
+  // The array can be already collected, with its finalizer still pending
+  if (cached == nullptr) return Napi::Value();
+  context->memo.hits++;
+  return Napi::Value(env, cached);
+}
+
+// Called when the conversion of an immutable container is complete
+// Its elements that are containers are already frozen
+void PyObjectWrap::_ToJS_MemoStore(Napi::Env env, const PyWeakRef &py, Napi::Value r) {
+  auto context = env.GetInstanceData<EnvContext>();
+  context->memo.misses++;
+
+  napi_status status = napi_object_freeze(env, r);
+  if (status != napi_ok) throw Error::New(env);
+  napi_ref ref;
+  status = napi_create_reference(env, r, 0, &ref);
+  if (status != napi_ok) throw Error::New(env);
+
+  napi_ref *entry = context->memo.entries.find(*py);
+  if (entry != nullptr) {
+    // A previous conversion that has been collected, its finalizer is still pending
+    // The entry keeps its reference to the Python object
+    napi_delete_reference(env, *entry);
+    *entry = ref;
+  } else {
+    Py_INCREF(*py);
+    context->memo.entries.insert(*py, ref);
+  }
+  status = napi_add_finalizer(env, r, *py, Memo_Finalizer, ref, nullptr);
+  if (status != napi_ok) throw Error::New(env);
+}
+
+Value PyObjectWrap::MemoCache(const CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1 || !info[0].IsBoolean()) throw TypeError::New(env, "Argument must be a boolean");
+  auto context = env.GetInstanceData<EnvContext>();
+  context->memo.enabled = info[0].ToBoolean().Value();
+
+  if (!context->memo.enabled) {
+    PyGILGuard pyGilGuard;
+    MemoClear(env, context);
+  }
+  return env.Undefined();
+}
+
+// Releases all the entries, must be called with the GIL held
+// The pending finalizers will not find their entries
+void PyObjectWrap::MemoClear(napi_env env, EnvContext *context) {
+  std::vector<PyObject *> cached;
+  context->memo.entries.for_each([&cached, env](PyObject *py, napi_ref ref) {
+    napi_delete_reference(env, ref);
+    cached.push_back(py);
+  });
+  for (PyObject *py : cached) {
+    context->memo.entries.erase(py);
+    Py_DECREF(py);
+  }
+}
+
+Value PyObjectWrap::MemoStats(const CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  auto context = env.GetInstanceData<EnvContext>();
+  Object r = Object::New(env);
+
+  r.Set("enabled", Boolean::New(env, context->memo.enabled));
+  r.Set("size", Number::New(env, static_cast<double>(context->memo.entries.size())));
+  r.Set("hits", Number::New(env, static_cast<double>(context->memo.hits)));
+  r.Set("misses", Number::New(env, static_cast<double>(context->memo.misses)));
+  return r;
+}
@@ -0,0 +1,141 @@
+#include "pymport.h"
+#include "pystackobject.h"
+#include "values.h"
+#include "memory.h"
+
+using namespace Napi;
+using namespace pymport;
+
+std::atomic<memory::Mode> memory::mode{memory::ESTIMATE};
+
+// tracemalloc.get_traced_memory
+static PyStrongRef get_traced_memory = nullptr;
+
+void memory::Init() {
+  if (get_traced_memory != nullptr) {
+    VERBOSE(INIT, "Re-initializing get_traced_memory (Python shutdown without dlclose)\n");
+    get_traced_memory = nullptr;
+  }
+  mode = ESTIMATE;
+}
+
+// Estimate the memory used by a Python object in bytes
+// The goal is to give V8 an idea of the memory pressure, not to be exact:
+// * buffer exporters (bytes, bytearray, array.array, numpy arrays...) report
+//   the size of the exported buffer which is usually the bulk of their memory
+// * lists, tuples, dicts and sets report their pointer arrays
+// * strings report their characters
+// * everything else reports its basic size
+// The elements of the containers are not included, they are separate objects
+// This is called for every wrapped object and it never runs Python code:
+// only the C-level sizes are used and Python-level __buffer__ methods are skipped
+Py_ssize_t memory::Estimate(PyObject *obj) {
+  PyTypeObject *type = Py_TYPE(obj);
+
+  if (obj == Py_None || PyBool_Check(obj) || PyFloat_Check(obj) || PyLong_Check(obj) || PyModule_Check(obj) ||
+      PyType_Check(obj))
+    return type->tp_basicsize;
+
+  if (PyList_Check(obj))
+    return type->tp_basicsize + reinterpret_cast<PyListObject *>(obj)->allocated * sizeof(PyObject *);
+
+  if (PyTuple_Check(obj)) return type->tp_basicsize + PyTuple_GET_SIZE(obj) * sizeof(PyObject *);
+
+  if (PyUnicode_Check(obj)) {
+#if PY_MAJOR_VERSION == 3 && PY_MINOR_VERSION < 12
+    if (PyUnicode_READY(obj) < 0) {
+      PyErr_Clear();
+      return type->tp_basicsize;
+    }
+#endif
+    return type->tp_basicsize + (PyUnicode_GET_LENGTH(obj) + 1) * PyUnicode_KIND(obj);
+  }
+
+  // Every entry holds a hash, a key and a value
+  if (PyDict_Check(obj)) return type->tp_basicsize + PyDict_GET_SIZE(obj) * 3 * sizeof(PyObject *);
+
+  // Every entry holds a key and a hash
+  if (PyAnySet_Check(obj)) return type->tp_basicsize + PySet_GET_SIZE(obj) * 2 * sizeof(PyObject *);
+
+  // A Python class that implements __buffer__ has its own getbuffer slot,
+  // the subclasses of the C buffer exporters inherit it from their base
+  if (PyObject_CheckBuffer(obj) &&
+      (!PyType_HasFeature(type, Py_TPFLAGS_HEAPTYPE) ||
+       (type->tp_base != nullptr && type->tp_base->tp_as_buffer != nullptr &&
+        type->tp_base->tp_as_buffer->bf_getbuffer == type->tp_as_buffer->bf_getbuffer))) {
+    Py_buffer view;
+    // This accepts non-contiguous buffers, len is always the size in bytes
+    if (PyObject_GetBuffer(obj, &view, PyBUF_RECORDS_RO) == 0) {
+      Py_ssize_t len = view.len;
+      PyBuffer_Release(&view);
+      return type->tp_basicsize + len;
+    }
+    PyErr_Clear();
+  }
+
+  // Other variable-size objects
+  if (type->tp_itemsize != 0) {
+    Py_ssize_t n = Py_SIZE(obj);
+    return type->tp_basicsize + type->tp_itemsize * (n < 0 ? -n : n);
+  }
+
+  return type->tp_basicsize;
+}
+
+// Can the size of this object change after it has been wrapped
+bool memory::Growable(PyObject *obj) {
+  return PyList_Check(obj) || PyDict_Check(obj) || PySet_Check(obj) || PyByteArray_Check(obj);
+}
+
+void memory::EnableTraceMalloc() {
+  if (get_traced_memory != nullptr) return;
+
+  PyStrongRef tracemalloc = PyImport_ImportModule("tracemalloc");
+  if (tracemalloc == nullptr) return;
+
+  PyStrongRef is_tracing = PyObject_CallMethod(*tracemalloc, "is_tracing", nullptr);
+  if (is_tracing == nullptr) return;
+  if (*is_tracing != Py_True) {
+    PyStrongRef r = PyObject_CallMethod(*tracemalloc, "start", nullptr);
+    if (r == nullptr) return;
+  }
+
+  get_traced_memory = PyObject_GetAttrString(*tracemalloc, "get_traced_memory");
+}
+
+Py_ssize_t memory::TracedMemory() {
+  if (get_traced_memory == nullptr) return -1;
+  PyStrongRef traced = PyObject_CallNoArgs(*get_traced_memory);
+  if (traced == nullptr || !PyTuple_Check(*traced) || PyTuple_Size(*traced) < 1) return -1;
+  return PyLong_AsSsize_t(PyTuple_GetItem(*traced, 0));
+}
+
+// Report the Python heap to V8 when in TRACEMALLOC mode
+// Only the difference since the last sample is reported
+void PyObjectWrap::SampleTracedMemory(Napi::Env env) {
+  auto context = env.GetInstanceData<EnvContext>();
+  int64_t current = 0;
+  if (memory::mode == memory::TRACEMALLOC) {
+    Py_ssize_t traced = memory::TracedMemory();
+    if (traced < 0) {
+      PyErr_Clear();
+      return;
+    }
+    current = static_cast<int64_t>(traced);
+  }
+  if (current != context->traced_memory) {
+    Napi::MemoryManagement::AdjustExternalMemory(env, current - context->traced_memory);
+    context->traced_memory = current;
+  }
+}
+
+// Refresh the estimation for objects that can grow after being wrapped
+void PyObjectWrap::UpdateMemoryHint(Napi::Env env) {
+  if (memory::mode != memory::ESTIMATE || !memory::Growable(*self)) return;
+
+  Py_ssize_t size = memory::Estimate(*self);
+  if (size != memory_hint) {
+    Napi::MemoryManagement::AdjustExternalMemory(env, static_cast<int64_t>(size - memory_hint));
+    memory_hint = size;
+  }
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <atomic>
+#include "values.h"
+#include "pystackobject.h"
+
+namespace pymport {
+namespace memory {
+
+// How the Python memory is reported to V8 as external memory
+// * ESTIMATE: every PyObject reports an estimation of its own size
+// * TRACEMALLOC: the whole Python heap as measured by tracemalloc is reported
+//   and the individual objects do not report anything
+enum Mode { ESTIMATE, TRACEMALLOC };
+extern std::atomic<Mode> mode;
+
+extern void Init();
+
+// These must be called with the GIL held
+extern Py_ssize_t Estimate(PyObject *);
+extern bool Growable(PyObject *);
+extern void EnableTraceMalloc();
+// Returns -1 on error
+extern Py_ssize_t TracedMemory();
+
+}; // namespace memory
+}; // namespace pymport
@@ -9,6 +9,30 @@ using namespace pymport;
 // This is naturally segregated by environment
 static std::map<PyObject *, Reference<Buffer<char>> *> memview_store;
 
+// Destroy a V8 Persistent Reference from a Python context
+// This has to run in the V8 thread
+template <typename T> static void ReleaseV8Reference(Reference<T> *persistent) {
+  auto finalizer = [persistent]() {
+    persistent->Reset();
+    delete persistent;
+  };
+
+  Napi::Env env = persistent->Env();
+  auto context = env.GetInstanceData<EnvContext>();
+#ifndef DEBUG
+  if (std::this_thread::get_id() == context->v8_main)
+    finalizer();
+  else
+#endif
+  {
+    VERBOSE(MEMV, "memview asynchronous finalization\n");
+    std::lock_guard<std::mutex> lock(context->v8_queue.lock);
+    context->v8_queue.jobs.emplace(std::move(finalizer));
+    auto r = uv_async_send(context->v8_queue.handle);
+    assert(r == 0);
+  }
+}
+
 // A MemView_Finalizer_Type is a Python callable type
 // It is used to register a WeakRef finalizer that is called when a memview is destroyed by Python
 // This also destroys the V8 Persistent Reference
@@ -27,27 +51,7 @@ static PyObject *MemView_Finalizer(PyObject *self, PyObject *args, PyObject *kw)
   auto v8_buffer = it->second;
   memview_store.erase(*weak);
 
-  // Destroy the V8 Persistent Reference
-  // This has to run in the V8 thread
-  auto finalizer = [v8_buffer]() {
-    v8_buffer->Reset();
-    delete v8_buffer;
-  };
-
-  auto env = v8_buffer->Env();
-  auto context = env.GetInstanceData<EnvContext>();
-#ifndef DEBUG
-  if (std::this_thread::get_id() == context->v8_main)
-    finalizer();
-  else
-#endif
-  {
-    VERBOSE(MEMV, "memview asynchronous finalization\n");
-    std::lock_guard<std::mutex> lock(context->v8_queue.lock);
-    context->v8_queue.jobs.emplace(std::move(finalizer));
-    auto r = uv_async_send(context->v8_queue.handle);
-    assert(r == 0);
-  }
+  ReleaseV8Reference(v8_buffer);
 
   Py_RETURN_NONE;
 }
@@ -59,6 +63,69 @@ static PyType_Spec memview_finalizer_spec = {
 
 static PyStrongRef MemView_Finalizer_Type = nullptr;
 
+// A JSBuffer_Exporter is a Python object implementing the Buffer Protocol
+// that exports the memory of a TypedArray, a DataView or an ArrayBuffer
+// It holds a V8 Persistent Reference to the JS object which is destroyed
+// when Python destroys the exporter - unlike a memoryview created from memory,
+// the exporter is the owner of the memory for all Python buffer consumers
+// (memoryviews of memoryviews, numpy arrays...)
+struct JSBuffer_Exporter {
+  PyObject_HEAD;
+  Reference<Object> *persistent;
+  void *data;
+  Py_ssize_t len;
+  Py_ssize_t shape;
+  Py_ssize_t itemsize;
+  const char *format;
+};
+
+// Called from Python context
+static int JSBuffer_GetBuffer(PyObject *self, Py_buffer *view, int flags) {
+  auto me = reinterpret_cast<JSBuffer_Exporter *>(self);
+  if (me->persistent == nullptr) {
+    PyErr_SetString(PyExc_BufferError, "JS buffer is not initialized");
+    return -1;
+  }
+
+  Py_INCREF(self);
+  view->obj = self;
+  view->buf = me->data;
+  view->len = me->len;
+  view->readonly = 0;
+  view->itemsize = me->itemsize;
+  view->format = (flags & PyBUF_FORMAT) == PyBUF_FORMAT ? const_cast<char *>(me->format) : nullptr;
+  view->ndim = 1;
+  view->shape = (flags & PyBUF_ND) == PyBUF_ND ? &me->shape : nullptr;
+  view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? &me->itemsize : nullptr;
+  view->suboffsets = nullptr;
+  view->internal = nullptr;
+  return 0;
+}
+
+// Called from Python context, can run in every thread
+static void JSBuffer_Finalizer(PyObject *self) {
+  VERBOSE_PYOBJ(MEMV, self, "js_buffer finalizer");
+  auto me = reinterpret_cast<JSBuffer_Exporter *>(self);
+  PyTypeObject *type = Py_TYPE(self);
+
+  if (me->persistent != nullptr) ReleaseV8Reference(me->persistent);
+
+  type->tp_free(self);
+  Py_DECREF(type);
+}
+
+static PyType_Slot jsbuffer_exporter_slots[] = {
+  {Py_tp_dealloc, reinterpret_cast<void *>(JSBuffer_Finalizer)},
+#if PY_VERSION_HEX >= 0x03090000
+  {Py_bf_getbuffer, reinterpret_cast<void *>(JSBuffer_GetBuffer)},
+#endif
+  {0, 0}};
+
+static PyType_Spec jsbuffer_exporter_spec = {
+  "pymport.js_buffer", sizeof(JSBuffer_Exporter), 0, Py_TPFLAGS_DEFAULT, jsbuffer_exporter_slots};
+
+static PyStrongRef JSBuffer_Exporter_Type = nullptr;
+
 void memview::Init() {
   if (MemView_Finalizer_Type != nullptr) {
     VERBOSE(INIT, "Re-initializing MemView_Finalizer_Type (Python shutdown without dlclose)\n");
@@ -70,6 +137,86 @@ void memview::Init() {
     fprintf(stderr, "Error memview finalizer type\n");
     abort();
   }
+
+  if (JSBuffer_Exporter_Type != nullptr) {
+    VERBOSE(INIT, "Re-initializing JSBuffer_Exporter_Type (Python shutdown without dlclose)\n");
+    JSBuffer_Exporter_Type = nullptr;
+  }
+  JSBuffer_Exporter_Type = PyType_FromSpec(&jsbuffer_exporter_spec);
+
+  if (JSBuffer_Exporter_Type == nullptr) {
+    fprintf(stderr, "Error js_buffer exporter type\n");
+    abort();
+  }
+#if PY_VERSION_HEX < 0x03090000
+  // Python 3.8 does not support the buffer slots in PyType_Spec
+  reinterpret_cast<PyHeapTypeObject *>(*JSBuffer_Exporter_Type)->as_buffer.bf_getbuffer = JSBuffer_GetBuffer;
+#endif
+}
+
+// The struct module format and the item size of each TypedArray type
+static const std::map<napi_typedarray_type, std::pair<const char *, Py_ssize_t>> typedarray_formats = {
+  {napi_int8_array, {"b", 1}},
+  {napi_uint8_array, {"B", 1}},
+  {napi_uint8_clamped_array, {"B", 1}},
+  {napi_int16_array, {"h", 2}},
+  {napi_uint16_array, {"H", 2}},
+  {napi_int32_array, {"i", 4}},
+  {napi_uint32_array, {"I", 4}},
+  {napi_float32_array, {"f", 4}},
+  {napi_float64_array, {"d", 8}},
+  {napi_bigint64_array, {"q", 8}},
+  {napi_biguint64_array, {"Q", 8}}};
+
+// Returns a memoryview that references directly the memory of a TypedArray,
+// a DataView or an ArrayBuffer - the format of a TypedArray is preserved,
+// DataViews and ArrayBuffers are exported as bytes
+PyStrongRef PyObjectWrap::_FromJS_TypedArray(Napi::Value v) {
+  Napi::Env env = v.Env();
+  void *data;
+  size_t len;
+  const char *format = "B";
+  Py_ssize_t itemsize = 1;
+
+  if (v.IsTypedArray()) {
+    napi_typedarray_type type;
+    size_t length;
+    napi_status status = napi_get_typedarray_info(env, v, &type, &length, &data, nullptr, nullptr);
+    if (status != napi_ok) throw Error::New(env);
+    auto fmt = typedarray_formats.find(type);
+    if (fmt == typedarray_formats.end()) throw TypeError::New(env, "Unsupported TypedArray type");
+    format = fmt->second.first;
+    itemsize = fmt->second.second;
+    len = length * itemsize;
+  } else if (v.IsDataView()) {
+    auto dataview = v.As<DataView>();
+    data = dataview.Data();
+    len = dataview.ByteLength();
+  } else {
+    auto arraybuffer = v.As<ArrayBuffer>();
+    data = arraybuffer.Data();
+    len = arraybuffer.ByteLength();
+  }
+  // An empty (or detached) buffer does not have memory
+  static char empty;
+  if (data == nullptr) data = &empty;
+
+  auto type = reinterpret_cast<PyTypeObject *>(*JSBuffer_Exporter_Type);
+  PyStrongRef exporter = type->tp_alloc(type, 0);
+  EXCEPTION_CHECK(env, exporter);
+  auto me = reinterpret_cast<JSBuffer_Exporter *>(*exporter);
+  me->data = data;
+  me->len = static_cast<Py_ssize_t>(len);
+  me->itemsize = itemsize;
+  me->shape = me->len / itemsize;
+  me->format = format;
+  me->persistent = new Reference<Object>();
+  *me->persistent = Persistent(v.As<Object>());
+  VERBOSE_PYOBJ(MEMV, *exporter, "js_buffer new");
+
+  PyStrongRef memoryView = PyMemoryView_FromObject(*exporter);
+  EXCEPTION_CHECK(env, memoryView);
+  return memoryView;
 }
 
 Value PyObjectWrap::MemoryView(const CallbackInfo &info) {
@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "pymport.h"
+#include "pystackobject.h"
+#include "values.h"
+
+using namespace Napi;
+using namespace pymport;
+
+// Conversion of N-dimensional buffers (numpy arrays, array.array, memoryviews...)
+// to TypedArrays
+//
+// The element type comes from the struct module format of the buffer, the result
+// is always a C-contiguous copy - the non-contiguous views (transposes, slices
+// with steps) are packed by a strided gather that runs without the GIL
+// and is split between several threads for the large arrays
+
+// Arrays larger than this are copied without the GIL
+static constexpr Py_ssize_t unlocked_gather_threshold = 1024 * 1024;
+// Minimum size of the work of each gather thread
+static constexpr Py_ssize_t gather_thread_chunk = 4 * 1024 * 1024;
+
+// Only native byte order is supported, the element size comes from the buffer
+static bool GetTypedArrayType(const char *format, Py_ssize_t itemsize, napi_typedarray_type &type) {
+  if (format == nullptr) format = "B";
+  if (*format == '@' || *format == '=' || *format == '<') format++;
+  if (format[0] == 0 || format[1] != 0) return false;
+
+  switch (format[0]) {
+    case 'f':
+      if (itemsize != 4) return false;
+      type = napi_float32_array;
+      return true;
+    case 'd':
+      if (itemsize != 8) return false;
+      type = napi_float64_array;
+      return true;
+    case 'b':
+    case 'h':
+    case 'i':
+    case 'l':
+    case 'q':
+    case 'n':
+      switch (itemsize) {
+        case 1:
+          type = napi_int8_array;
+          return true;
+        case 2:
+          type = napi_int16_array;
+          return true;
+        case 4:
+          type = napi_int32_array;
+          return true;
+        case 8:
+          type = napi_bigint64_array;
+          return true;
+      }
+      return false;
+    case 'B':
+    case 'H':
+    case 'I':
+    case 'L':
+    case 'Q':
+    case 'N':
+    case 'c':
+    case '?':
+      switch (itemsize) {
+        case 1:
+          type = napi_uint8_array;
+          return true;
+        case 2:
+          type = napi_uint16_array;
+          return true;
+        case 4:
+          type = napi_uint32_array;
+          return true;
+        case 8:
+          type = napi_biguint64_array;
+          return true;
+      }
+      return false;
+  }
+  return false;
+}
+
+// The fixed element sizes compile to a single load/store per element and
+// a contiguous destination, which the compiler can vectorize
+template <typename T> static inline void GatherRow(char *dst, const char *src, Py_ssize_t n, Py_ssize_t stride) {
+  for (Py_ssize_t i = 0; i < n; i++) memcpy(dst + i * sizeof(T), src + i * stride, sizeof(T));
+}
+
+static void GatherRow(char *dst, const char *src, Py_ssize_t n, Py_ssize_t stride, Py_ssize_t itemsize) {
+  if (stride == itemsize) {
+    memcpy(dst, src, n * itemsize);
+    return;
+  }
+  switch (itemsize) {
+    case 1:
+      GatherRow<uint8_t>(dst, src, n, stride);
+      break;
+    case 2:
+      GatherRow<uint16_t>(dst, src, n, stride);
+      break;
+    case 4:
+      GatherRow<uint32_t>(dst, src, n, stride);
+      break;
+    case 8:
+      GatherRow<uint64_t>(dst, src, n, stride);
+      break;
+    default:
+      for (Py_ssize_t i = 0; i < n; i++) memcpy(dst + i * itemsize, src + i * stride, itemsize);
+  }
+}
+
+// Packs the sub-array at src starting from dimension dim, returns the end of the written data
+static char *Gather(char *dst, const char *src, int dim, const Py_buffer &view) {
+  if (dim == view.ndim - 1) {
+    GatherRow(dst, src, view.shape[dim], view.strides[dim], view.itemsize);
+    return dst + view.shape[dim] * view.itemsize;
+  }
+  for (Py_ssize_t i = 0; i < view.shape[dim]; i++) dst = Gather(dst, src + i * view.strides[dim], dim + 1, view);
+  return dst;
+}
+
+// Packs the elements [start, end) of the first dimension
+static void GatherRange(char *dst, const Py_buffer &view, Py_ssize_t start, Py_ssize_t end) {
+  const char *src = static_cast<const char *>(view.buf);
+  if (view.ndim == 1) {
+    GatherRow(
+      dst + start * view.itemsize, src + start * view.strides[0], end - start, view.strides[0], view.itemsize);
+    return;
+  }
+  Py_ssize_t row = view.len / view.shape[0];
+  for (Py_ssize_t i = start; i < end; i++) Gather(dst + i * row, src + i * view.strides[0], 1, view);
+}
+
+// The first dimension is split between the threads
+static void GatherParallel(char *dst, const Py_buffer &view) {
+  Py_ssize_t threads = std::min<Py_ssize_t>(
+    {static_cast<Py_ssize_t>(std::max(1u, std::thread::hardware_concurrency())),
+     view.shape[0],
+     view.len / gather_thread_chunk});
+  if (threads <= 1) {
+    GatherRange(dst, view, 0, view.shape[0]);
+    return;
+  }
+
+  std::vector<std::thread> workers;
+  Py_ssize_t chunk = (view.shape[0] + threads - 1) / threads;
+  for (Py_ssize_t start = chunk; start < view.shape[0]; start += chunk)
+    workers.emplace_back(GatherRange, dst, std::cref(view), start, std::min(start + chunk, view.shape[0]));
+  GatherRange(dst, view, 0, std::min(chunk, view.shape[0]));
+  for (auto &w : workers) w.join();
+}
+
+// Releases the Py_buffer on all return paths, including the exceptions
+struct PyBufferGuard {
+  Py_buffer *view;
+  ~PyBufferGuard() {
+    PyBuffer_Release(view);
+  }
+};
+
+Napi::Value PyObjectWrap::_ToTypedArray(Napi::Env env, const PyWeakRef &py) {
+  if (!PyObject_CheckBuffer(*py)) throw TypeError::New(env, "Object does not support the Buffer protocol");
+  Py_buffer view;
+  // Strided and read-only buffers are accepted, indirect (PIL-style) buffers are not
+  int status = PyObject_GetBuffer(*py, &view, PyBUF_RECORDS_RO);
+  EXCEPTION_CHECK(env, status);
+  PyBufferGuard guard{&view};
+
+  napi_typedarray_type type;
+  if (!GetTypedArrayType(view.format, view.itemsize, type)) {
+    std::string format = view.format != nullptr ? view.format : "";
+    throw TypeError::New(env, "Buffer format '" + format + "' is not supported");
+  }
+
+  ArrayBuffer data = ArrayBuffer::New(env, view.len);
+  char *dst = static_cast<char *>(data.Data());
+  bool contiguous = PyBuffer_IsContiguous(&view, 'C');
+  if (view.len == 0) {
+    // Nothing to copy
+  } else if (view.len >= unlocked_gather_threshold) {
+    // The exported memory cannot be resized or freed while the Py_buffer is held
+    Py_BEGIN_ALLOW_THREADS;
+    if (contiguous)
+      memcpy(dst, view.buf, view.len);
+    else
+      GatherParallel(dst, view);
+    Py_END_ALLOW_THREADS;
+  } else if (contiguous || view.ndim == 0) {
+    memcpy(dst, view.buf, view.len);
+  } else {
+    GatherRange(dst, view, 0, view.shape[0]);
+  }
+
+  napi_value raw;
+  napi_status r = napi_create_typedarray(env, type, view.len / view.itemsize, data, 0, &raw);
+  if (r != napi_ok) throw Error::New(env);
+  Object result(env, raw);
+
+  // The strides of the packed array, in elements
+  Napi::Array shape = Napi::Array::New(env, view.ndim);
+  Napi::Array strides = Napi::Array::New(env, view.ndim);
+  Py_ssize_t stride = 1;
+  for (int i = view.ndim - 1; i >= 0; i--) {
+    shape.Set(i, Number::New(env, static_cast<double>(view.shape[i])));
+    strides.Set(i, Number::New(env, static_cast<double>(stride)));
+    stride *= view.shape[i];
+  }
+  result.Set("shape", shape);
+  result.Set("strides", strides);
+
+  return result;
+}
+
+Value PyObjectWrap::ToTypedArray(const CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  PyGILGuard pyGilGuard;
+
+  return _ToTypedArray(env, self);
+}
@@ -0,0 +1,148 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "pystackobject.h"
+
+namespace pymport {
+
+// A flat open-addressing hash table keyed by PyObject pointers
+// This is the backing store of the Object Store and the Function Store
+// (refer to objstore.cc)
+//
+// * linear probing over a power-of-two array of slots, so that a lookup
+//   is usually a single cache line
+// * erasing leaves a tombstone so that the probe chains of the other
+//   entries remain intact, the tombstones are reused by the following
+//   insertions and are purged when the table is rehashed
+// * pointers to values remain valid until the next insertion, erasing
+//   never moves other entries - this is important because the V8 GC can
+//   erase entries (finalizers) while we are holding a pointer
+//
+// It is not thread-safe, it is always accessed from the V8 main thread
+// with the GIL held
+template <typename T> class PyObjectMap {
+  struct Slot {
+    PyObject *key;
+    T value;
+  };
+
+  // nullptr marks an empty slot, this is never a valid PyObject pointer
+  static inline PyObject *Tombstone() {
+    return reinterpret_cast<PyObject *>(static_cast<uintptr_t>(1));
+  }
+
+  static constexpr size_t initial_capacity = 64;
+
+  Slot *slots;
+  size_t capacity;
+  size_t used;
+  size_t tombstones;
+
+  // PyObjects are at least 16-byte aligned, the low bits carry no information
+  // Fibonacci hashing spreads the consecutive addresses of the allocator
+  INLINE size_t Hash(PyObject *key) const {
+    uint64_t k = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(key)) >> 4;
+    return static_cast<size_t>((k * 0x9E3779B97F4A7C15ULL) >> 32) & (capacity - 1);
+  }
+
+  void Rehash(size_t new_capacity) {
+    Slot *old = slots;
+    size_t old_capacity = capacity;
+
+    slots = static_cast<Slot *>(calloc(new_capacity, sizeof(Slot)));
+    if (slots == nullptr) {
+      fprintf(stderr, "Out of memory growing the object store\n"); //LCOV_EXCL_LINE
+      abort();                                                    //LCOV_EXCL_LINE
+    }
+    capacity = new_capacity;
+    tombstones = 0;
+
+    for (size_t i = 0; i < old_capacity; i++) {
+      if (old[i].key == nullptr || old[i].key == Tombstone()) continue;
+      size_t idx = Hash(old[i].key);
+      while (slots[idx].key != nullptr) idx = (idx + 1) & (capacity - 1);
+      slots[idx] = old[i];
+    }
+    free(old);
+  }
+
+    public:
+  PyObjectMap() : slots(nullptr), capacity(initial_capacity), used(0), tombstones(0) {
+    slots = static_cast<Slot *>(calloc(capacity, sizeof(Slot)));
+    if (slots == nullptr) abort(); //LCOV_EXCL_LINE
+  }
+
+  PyObjectMap(const PyObjectMap &) = delete;
+  PyObjectMap &operator=(const PyObjectMap &) = delete;
+
+  ~PyObjectMap() {
+    free(slots);
+  }
+
+  INLINE size_t size() const {
+    return used;
+  }
+
+  // Returns a pointer to the stored value or nullptr
+  INLINE T *find(PyObject *key) const {
+    size_t idx = Hash(key);
+    while (slots[idx].key != nullptr) {
+      if (slots[idx].key == key) return &slots[idx].value;
+      idx = (idx + 1) & (capacity - 1);
+    }
+    return nullptr;
+  }
+
+  // The key must not be present
+  // The first tombstone on the probe chain is reused
+  void insert(PyObject *key, T value) {
+    ASSERT(key != nullptr && key != Tombstone());
+    ASSERT(find(key) == nullptr);
+
+    // Keep the load factor (including the tombstones) under 3/4
+    if ((used + tombstones + 1) * 4 > capacity * 3) {
+      // When most of the load are tombstones, a same-size rehash is enough
+      Rehash((used + 1) * 2 > capacity ? capacity * 2 : capacity);
+    }
+
+    size_t idx = Hash(key);
+    while (slots[idx].key != nullptr && slots[idx].key != Tombstone()) idx = (idx + 1) & (capacity - 1);
+    if (slots[idx].key == Tombstone()) tombstones--;
+    slots[idx].key = key;
+    slots[idx].value = value;
+    used++;
+  }
+
+  // Calls fn(key, value) for every entry
+  // fn must not insert new entries
+  template <typename F> void for_each(F fn) const {
+    for (size_t i = 0; i < capacity; i++) {
+      if (slots[i].key == nullptr || slots[i].key == Tombstone()) continue;
+      fn(slots[i].key, slots[i].value);
+    }
+  }
+
+  // Returns false if the key is not present
+  bool erase(PyObject *key) {
+    size_t idx = Hash(key);
+    while (slots[idx].key != nullptr) {
+      if (slots[idx].key == key) {
+        // If the next slot is empty, no probe chain passes through here
+        if (slots[(idx + 1) & (capacity - 1)].key == nullptr) {
+          slots[idx].key = nullptr;
+        } else {
+          slots[idx].key = Tombstone();
+          tombstones++;
+        }
+        used--;
+        return true;
+      }
+      idx = (idx + 1) & (capacity - 1);
+    }
+    return false;
+  }
+};
+
+} // namespace pymport
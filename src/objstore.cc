@@ -1,6 +1,8 @@
 #include "pymport.h"
 #include "pystackobject.h"
 #include "values.h"
+#include "release.h"
+#include "memory.h"
 
 using namespace Napi;
 using namespace pymport;
@@ -21,15 +23,16 @@ Value PyObjectWrap::New(Napi::Env env, PyStrongRef &&obj) {
   VERBOSE_PYOBJ(OBJS, *obj, "Objstore new");
 
   Object js;
-  auto it = context->object_store.find(*obj);
-  if (it == context->object_store.end() || it->second->Value().IsEmpty()) {
+  PyObjectWrap **stored = context->object_store.find(*obj);
+  if (stored == nullptr || (*stored)->Value().IsEmpty()) {
     // This IsEmpty() situation is pending an award for most cumbersome API of the decade
     // (a JS object can be marked for deletion with a deferred destruction)
-    if (it != context->object_store.end()) {
+    if (stored != nullptr) {
       // prevent the dying object from deleting the entry of the new one
       // as they share the same PyObject
+      // (this leaves a tombstone that will be reused by the insertion below)
       VERBOSE_PYOBJ(OBJS, *obj, "Objstore is dying");
-      auto o = it->second;
+      auto o = *stored;
       context->object_store.erase(*o->self);
       o->self = nullptr;
     }
@@ -39,18 +42,22 @@ Value PyObjectWrap::New(Napi::Env env, PyStrongRef &&obj) {
     napi_value ext = External<PyObject>::New(env, obj.gift());
     napi_value jsval;
     napi_status r = napi_new_instance(env, context->pyObj->Value(), 1, &ext, &jsval);
-    if (r != napi_ok) {
-      napi_throw(env, Napi::Value());
-      return Napi::Value();
-    }
+    // This rethrows the pending JS exception if there is one
+    if (r != napi_ok) throw Error::New(env);
     js = Napi::Value(env, jsval).ToObject();
 
     auto result = ObjectWrap::Unwrap(js);
-    context->object_store.insert({*result->self, result});
+    context->object_store.insert(*result->self, result);
+
+    // In TRACEMALLOC mode, the Python heap is periodically reported to V8
+    if (memory::mode == memory::TRACEMALLOC && context->traced_memory_countdown-- == 0) {
+      context->traced_memory_countdown = 256;
+      SampleTracedMemory(env);
+    }
   } else {
     // Retrieve the existing object from the store
     VERBOSE_PYOBJ(OBJS, *obj, "Objstore retrieve");
-    js = it->second->Value();
+    js = (*stored)->Value();
     // Consume the reference in case of C++17 copy elision
     obj = nullptr;
   }
@@ -64,10 +71,10 @@ Value PyObjectWrap::NewCallable(Napi::Env env, PyStrongRef &&py) {
 
   VERBOSE_PYOBJ(CALL, *py, "Funcstore new callable");
   auto context = env.GetInstanceData<EnvContext>();
-  auto it = context->function_store.find(*py);
+  FunctionReference **stored = context->function_store.find(*py);
   Function js;
-  if (it == context->function_store.end() || it->second->Value().IsEmpty()) {
-    if (it != context->function_store.end()) {
+  if (stored == nullptr || (*stored)->Value().IsEmpty()) {
+    if (stored != nullptr) {
       // The function has been GCed but it hasn't been destroyed, same situation as objects above
       VERBOSE_PYOBJ(CALL, *py, "Funcstore evict dying");
       context->function_store.erase(*py);
@@ -85,7 +92,7 @@ Value PyObjectWrap::NewCallable(Napi::Env env, PyStrongRef &&py) {
     // The function store keeps weak references to allow the GC to free these objects
     FunctionReference *jsRef = new FunctionReference;
     *jsRef = Napi::Weak(js);
-    context->function_store.insert({*py, jsRef});
+    context->function_store.insert(*py, jsRef);
     js.AddFinalizer(
       [](Napi::BasicEnv env, FunctionReference *fini_fn, PyObject *fini_py) {
         // Skip if Python has been shut down
@@ -98,18 +105,21 @@ Value PyObjectWrap::NewCallable(Napi::Env env, PyStrongRef &&py) {
         }
 
         // This is called from a JS context
-        PyGILGuard pyGilGuard;
+        // The function store is accessed only from the V8 main thread, so in background
+        // release mode this does not wait for the GIL
+        std::optional<PyGILGuard> pyGilGuard;
+        if (!release::background) pyGilGuard.emplace();
         // As JS finalizers can be delayed,
         // the Python object might already be destroyed here
         VERBOSE(CALL, "Funcstore erase for %p\n", fini_py);
         auto context = env.GetInstanceData<EnvContext>();
-        auto stored = context->function_store.find(fini_py);
+        FunctionReference **stored = context->function_store.find(fini_py);
         // Does the stored function match our reference?
         // The only case where there could be a mismatch is if a dying function
         // has been evicted by the code above, in this case we should not delete
         // the reference which is that of the replacement function
         // (the function might not exist in the store with two consecutive dying scenarios)
-        if (stored != context->function_store.end() && stored->second == fini_fn) {
+        if (stored != nullptr && *stored == fini_fn) {
           context->function_store.erase(fini_py);
         } else {
           VERBOSE(CALL, "Funcstore already erased for %p\n", fini_py);
@@ -122,8 +132,8 @@ Value PyObjectWrap::NewCallable(Napi::Env env, PyStrongRef &&py) {
     js.DefineProperty(Napi::PropertyDescriptor::Value("__PyObject__", New(env, std::move(py)), napi_default));
   } else {
     VERBOSE_PYOBJ(CALL, *py, "Funcstore retrieve");
-    assert(!it->second->Value().IsEmpty());
-    js = it->second->Value();
+    assert(!(*stored)->Value().IsEmpty());
+    js = (*stored)->Value();
     // The caller expects this to be destroyed
     py = nullptr;
   }
@@ -139,7 +149,7 @@ void PyObjectWrap::Release() {
   Napi::Env env = Env();
   auto context = env.GetInstanceData<EnvContext>();
 
-  ASSERT(context->object_store.find(*self) != context->object_store.end());
+  ASSERT(context->object_store.find(*self) != nullptr);
   VERBOSE_PYOBJ(OBJS, *self, "Objstore erase");
   context->object_store.erase(*self);
 }
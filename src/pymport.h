@@ -5,23 +5,32 @@
 
 #include <map>
 #include <list>
+#include <memory>
+#include <vector>
 #include <set>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <functional>
 #include <queue>
 #include <shared_mutex>
+#include <optional>
 
 #include <napi.h>
 #include <uv.h>
 
 #include "pystackobject.h"
+#include "objmap.h"
 
 namespace pymport {
 
 // Refer to the Internals.md section in the wiki for a quick introduction
 
 typedef std::function<PyStrongRef()> PyCallExecutor;
+// Executes the i-th call of a callMany
+typedef std::function<PyStrongRef(size_t)> PyCallManyExecutor;
+
+struct EnvContext;
 
 // Must be constructed with the GIL held
 // ToJS can be called only from a V8 thread
@@ -40,9 +49,51 @@ class PythonException {
   Napi::Error ToJS(Napi::Env);
 };
 
+// Fire-and-forget mode of a JSCall_Trampoline (call.cc)
+// The calls are queued for the V8 main thread and return None immediately
+// Protected by the lock of EnvContext::js_async
+struct JSCall_Async {
+  // Maximum number of queued calls of this function
+  size_t limit;
+  // A full queue drops the call instead of blocking the calling thread
+  bool drop;
+  size_t queued;
+  size_t dropped;
+};
+
+// Conversion of the arguments of a JSCall_Trampoline (call.cc)
+enum JSCall_Args {
+  // PyObjects
+  JSCALL_ARGS_WRAP,
+  // The scalars are converted by value, the other objects are PyObjects
+  JSCALL_ARGS_VALUE,
+  // toJS() with args_depth
+  JSCALL_ARGS_TOJS
+};
+
+// A JSCall_Trampoline is a Python callable object that contains a JS function
+// This callable type cannot be constructed from Python and is normally not visible
+// except when inspecting a function object passed from JS
+// It has a PyType_Slot descriptor that can be found in call.cc
+typedef struct {
+  PyObject_HEAD;
+  Napi::FunctionReference *js_fn;
+  Napi::ThreadSafeFunction *js_tsfn;
+  // js_fn has been downgraded to a weak reference by the cycle collector (cycles.cc)
+  bool weak;
+  // nullptr for the synchronous functions
+  JSCall_Async *async;
+  JSCall_Args args_mode;
+  int args_depth;
+  // The vectorcall entry point, Python 3.9+ only
+  vectorcallfunc vectorcall;
+} JSCall_Trampoline;
+
 struct ToJSOpts {
   int depth;
   bool buffer;
+  // Share the memory of the buffers instead of copying (tojs.cc)
+  bool shared = false;
 };
 
 class PyObjectWrap : public Napi::ObjectWrap<PyObjectWrap> {
@@ -58,6 +109,11 @@ class PyObjectWrap : public Napi::ObjectWrap<PyObjectWrap> {
   Napi::Value Get(const Napi::CallbackInfo &);
   Napi::Value Call(const Napi::CallbackInfo &);
   Napi::Value CallAsync(const Napi::CallbackInfo &);
+  Napi::Value CallMethod(const Napi::CallbackInfo &);
+  Napi::Value CallMany(const Napi::CallbackInfo &);
+  Napi::Value CallManyAsync(const Napi::CallbackInfo &);
+  Napi::Value CallMethodAsync(const Napi::CallbackInfo &);
+  Napi::Value NextAsync(const Napi::CallbackInfo &);
   Napi::Value Item(const Napi::CallbackInfo &);
 
   Napi::Value Has(const Napi::CallbackInfo &);
@@ -67,11 +123,22 @@ class PyObjectWrap : public Napi::ObjectWrap<PyObjectWrap> {
   Napi::Value Constructor(const Napi::CallbackInfo &);
 
   static Napi::Value Import(const Napi::CallbackInfo &);
+  static Napi::Value CollectCycles(const Napi::CallbackInfo &);
+  static Napi::Value MemoCache(const Napi::CallbackInfo &);
+  static Napi::Value MemoStats(const Napi::CallbackInfo &);
+  static void MemoClear(napi_env, EnvContext *);
+  static Napi::Value GetMember(const Napi::CallbackInfo &);
+  static Napi::Value RunGraph(const Napi::CallbackInfo &);
+  static void RunJSAsyncCalls(uv_async_t *);
+  static void CloseJSAsyncCalls(EnvContext *);
+  static Napi::Value RunGraphAsync(const Napi::CallbackInfo &);
   static Napi::Value Eval(const Napi::CallbackInfo &);
 
   static Napi::Value FromJS(const Napi::CallbackInfo &);
   static Napi::Value ToJS(Napi::Env, const PyWeakRef &, ToJSOpts);
   Napi::Value ToJS(const Napi::CallbackInfo &);
+  Napi::Value ToTypedArray(const Napi::CallbackInfo &);
+  Napi::Value ToColumns(const Napi::CallbackInfo &);
 
   static Napi::Value Keys(const Napi::CallbackInfo &);
   static Napi::Value Values(const Napi::CallbackInfo &);
@@ -82,6 +149,8 @@ class PyObjectWrap : public Napi::ObjectWrap<PyObjectWrap> {
   static Napi::Value Dictionary(const Napi::CallbackInfo &);
   static Napi::Value Tuple(const Napi::CallbackInfo &);
   static Napi::Value List(const Napi::CallbackInfo &);
+  static Napi::Value NumberArray(const Napi::CallbackInfo &);
+  static Napi::Value CompileConverter(const Napi::CallbackInfo &);
   static Napi::Value Slice(const Napi::CallbackInfo &);
   static Napi::Value Set(const Napi::CallbackInfo &);
   static Napi::Value FrozenSet(const Napi::CallbackInfo &);
@@ -89,6 +158,7 @@ class PyObjectWrap : public Napi::ObjectWrap<PyObjectWrap> {
   static Napi::Value ByteArray(const Napi::CallbackInfo &);
   static Napi::Value MemoryView(const Napi::CallbackInfo &);
   static Napi::Value Functor(const Napi::CallbackInfo &);
+  static Napi::Value AsyncCallStats(const Napi::CallbackInfo &);
 
   static PyStrongRef FromJS(Napi::Value);
 
@@ -96,6 +166,7 @@ class PyObjectWrap : public Napi::ObjectWrap<PyObjectWrap> {
   static Napi::Value NewCallable(Napi::Env, PyStrongRef &&);
 
   static Napi::Function GetClass(Napi::Env);
+  static void SampleTracedMemory(Napi::Env);
   static void InitJSTrampoline();
 
   static inline void ExceptionCheck(
@@ -135,19 +206,57 @@ class PyObjectWrap : public Napi::ObjectWrap<PyObjectWrap> {
   }
 
     private:
-  typedef std::map<PyObject *, Napi::Value> NapiObjectStore;
-  typedef std::list<std::pair<Napi::Value, PyWeakRef>> PyObjectStore;
+  // Identity map of the JS objects already converted by _FromJS
+  // It breaks the recursion on circular references
+  // It also caches the interned Python strings of the property names
+  // Both are backed by JS Maps that are created on the first insertion (refer to fromjs.cc)
+  class PyObjectStore {
+    Napi::Object map;
+    std::vector<PyWeakRef> objects;
+    Napi::Object key_map;
+    std::vector<PyStrongRef> keys;
+
+      public:
+    PyWeakRef Find(Napi::Value);
+    void Insert(Napi::Value, const PyWeakRef &);
+    PyWeakRef Key(Napi::Value);
+  };
 
   void Release();
-
-  static Napi::Value _ToJS(Napi::Env, const PyWeakRef &, NapiObjectStore &, ToJSOpts);
-  static Napi::Value _ToJS_Dictionary(Napi::Env, const PyWeakRef &, NapiObjectStore &, ToJSOpts);
-  static Napi::Value _ToJS_Tuple(Napi::Env, const PyWeakRef &, NapiObjectStore &, ToJSOpts);
-  static Napi::Value _ToJS_List(Napi::Env, const PyWeakRef &, NapiObjectStore &, ToJSOpts);
-  static Napi::Value _ToJS_Set(Napi::Env, const PyWeakRef &, NapiObjectStore &, ToJSOpts);
-  static Napi::Value _ToJS_Dir(Napi::Env, const PyWeakRef &, NapiObjectStore &, ToJSOpts);
-  static Napi::Value _ToJS_Buffer(Napi::Env, const PyWeakRef &, NapiObjectStore &);
+  void UpdateMemoryHint(Napi::Env);
+
+  // The explicit work stack of the conversion to JS (refer to tojs.cc)
+  struct ToJSFrame;
+  struct ToJSState;
+  static Napi::Value _ToJS_Run(Napi::Env, const PyWeakRef &, ToJSOpts, bool);
+  static Napi::Value _ToJS_MemoFind(Napi::Env, const PyWeakRef &);
+  static void _ToJS_MemoStore(Napi::Env, const PyWeakRef &, Napi::Value);
+  static bool _ToJS_MemoElement(Napi::Env, const PyWeakRef &);
+  static Napi::Value _ToJS(Napi::Env, const PyWeakRef &, ToJSState &, ToJSOpts);
+  static Napi::Value _ToJS_Key(Napi::Env, const PyWeakRef &, ToJSState &, ToJSOpts);
+  static void _ToJS_Step(Napi::Env, ToJSState &);
+  static void _ToJS_Shape(Napi::Env, ToJSState &, ToJSFrame &);
+  static Napi::Value _ToJS_Record(Napi::Env, ToJSState &, ToJSFrame &, const PyWeakRef &);
+  static Napi::Value _ToJS_Buffer(Napi::Env, const PyWeakRef &, ToJSOpts, bool);
+
+  static Napi::Value _ToTypedArray(Napi::Env, const PyWeakRef &);
+
+  // Columnar conversion (columns.cc)
+  struct InterchangeBuffer;
+  static bool _InterchangeBuffer(Napi::Env, const PyWeakRef &, const char *, InterchangeBuffer &);
+  static Napi::Value _ToJS_InterchangeColumn(Napi::Env, const PyWeakRef &);
+
+  // Lazy conversion (lazy.cc)
+  static Napi::Value _ToJS_Lazy(Napi::Env, const PyWeakRef &, ToJSOpts);
+  static PyWeakRef _LazyFind(Napi::Env, Napi::Value, Napi::Value);
+  static Napi::Value _LazyElement(Napi::Env, Napi::Object, Napi::Value);
+  static Napi::Value LazyGet(const Napi::CallbackInfo &);
+  static Napi::Value LazyHas(const Napi::CallbackInfo &);
+  static Napi::Value LazyOwnKeys(const Napi::CallbackInfo &);
+  static Napi::Value LazyGetOwnPropertyDescriptor(const Napi::CallbackInfo &);
+  static Napi::Value _ToJS_SharedBuffer(Napi::Env, const PyWeakRef &);
   static Napi::Value _ToJS_JSFunction(Napi::Env, const PyWeakRef &);
+  static Napi::Value _ToJS_String(Napi::Env, const PyWeakRef &);
 
   static PyStrongRef _FromJS(Napi::Value, PyObjectStore &);
   static void _FromJS_Dictionary(Napi::Object, const PyStrongRef &, PyObjectStore &);
@@ -155,6 +264,40 @@ class PyObjectWrap : public Napi::ObjectWrap<PyObjectWrap> {
   static void _FromJS_Tuple(Napi::Array, const PyStrongRef &, PyObjectStore &);
   static void _FromJS_Set(Napi::Array, const PyStrongRef &, PyObjectStore &);
   static PyStrongRef _FromJS_BytesArray(Napi::Buffer<char>);
+  static PyStrongRef _FromJS_TypedArray(Napi::Value);
+  static PyStrongRef _FromJS_String(Napi::Value);
+  static PyStrongRef _FromJS_Number(Napi::Env, double);
+  static size_t _FromJS_ReadNumbers(Napi::Array, size_t, std::vector<double> &);
+
+  // Schema-compiled converters (converter.cc)
+  struct SchemaNode;
+  typedef std::shared_ptr<SchemaNode> SchemaRef;
+  static std::unique_ptr<SchemaNode> _CompileSchema(Napi::Env, Napi::Value);
+  static PyStrongRef _FromJS_Schema(Napi::Env, napi_value, const SchemaNode &, PyObjectStore &);
+  static PyStrongRef _FromJS_SchemaScalar(Napi::Env, napi_value, const SchemaNode &);
+  static PyStrongRef _FromJS_SchemaTop(Napi::Env, Napi::Value, const SchemaNode &);
+  static Napi::Value ConverterConvert(const Napi::CallbackInfo &);
+  static Napi::Value ConverterCall(const Napi::CallbackInfo &);
+  static Napi::Function _NewConverterFunction(
+    Napi::Env, Napi::Value (*)(const Napi::CallbackInfo &), const char *, const SchemaRef &);
+
+  // Synchronous calls (call.cc)
+  struct VectorcallArgs;
+  template <typename ARGS>
+  static void
+  _FromJS_VectorcallArgs(Napi::Env, const ARGS &, size_t, size_t, VectorcallArgs &, const SchemaNode * = nullptr);
+  static void _FromJS_Vectorcall(const Napi::CallbackInfo &, size_t, VectorcallArgs &, const SchemaNode * = nullptr);
+  static void _FromJS_Vectorcall(const Napi::Array &, VectorcallArgs &);
+  static PyStrongRef _Vectorcall(const PyWeakRef &, const Napi::CallbackInfo &);
+  static PyStrongRef _VectorcallMethod(const PyWeakRef &, const PyWeakRef &, VectorcallArgs &);
+  static PyWeakRef _MethodName(Napi::Env, Napi::Value);
+  static PyStrongRef _AttrName(Napi::Env, Napi::Value);
+
+  // Deferred expression graphs (graph.cc)
+  struct GraphNode;
+  struct Graph;
+  static std::shared_ptr<Graph> _CompileGraph(Napi::Env, Napi::Array);
+  static PyStrongRef _RunGraph(Graph &);
 
   static PyCallExecutor CreateCallExecutor(const PyWeakRef &, const Napi::CallbackInfo &info);
   static Napi::Value _CallableTrampoline(const Napi::CallbackInfo &info);
@@ -170,28 +313,142 @@ class PyObjectWrap : public Napi::ObjectWrap<PyObjectWrap> {
   static void _ExceptionThrow(Napi::Env);
 #endif
 
+  // Refer to the comment in cycles.cc
+  static void _CycleAnchorTouched(Napi::Env);
+  INLINE void Touch(Napi::Env env) {
+    if (cycle_anchor) {
+      cycle_anchor = false;
+      _CycleAnchorTouched(env);
+    }
+  }
+  template <Napi::Value (PyObjectWrap::*method)(const Napi::CallbackInfo &)>
+  Napi::Value Touched(const Napi::CallbackInfo &info) {
+    Touch(info.Env());
+    return (this->*method)(info);
+  }
+
   static PyStrongRef JSCall_Trampoline_Type;
   PyStrongRef self;
   Py_ssize_t memory_hint;
+  // Set by the cycle collector when a downgraded trampoline is reachable from this object
+  bool cycle_anchor;
 }; // namespace pymport
 
+// The arguments of a vectorcall converted from JS (call.cc)
+// The usual small calls do not allocate, the array is on the stack
+// Slot 0 is reserved for PY_VECTORCALL_ARGUMENTS_OFFSET or for the object of a method call
+// The named arguments follow the positional ones, their names are in kwnames
+// Must be destroyed with the GIL held
+struct PyObjectWrap::VectorcallArgs {
+  static constexpr size_t inline_size = 8;
+  PyObject *inline_args[inline_size + 1];
+  std::vector<PyObject *> heap_args;
+  PyObject **args;
+  size_t nargs;
+  size_t len;
+  PyStrongRef kwnames;
+
+  INLINE VectorcallArgs() : args(inline_args), nargs(0), len(0), kwnames(nullptr) {
+    args[0] = nullptr;
+  }
+  // args can point into the object itself
+  VectorcallArgs(const VectorcallArgs &) = delete;
+  VectorcallArgs(VectorcallArgs &&) = delete;
+  VectorcallArgs &operator=(const VectorcallArgs &) = delete;
+  VectorcallArgs &operator=(VectorcallArgs &&) = delete;
+
+  INLINE void Reserve(size_t n) {
+    if (n <= inline_size) return;
+    heap_args.resize(n + 1);
+    args = heap_args.data();
+    args[0] = nullptr;
+  }
+
+  // Steals the reference
+  INLINE void Push(PyStrongRef &&v) {
+    args[++len] = v.gift();
+  }
+
+  // An empty slot filled later with a strong reference (graph.cc)
+  INLINE size_t Placeholder() {
+    args[++len] = nullptr;
+    return len;
+  }
+
+  INLINE ~VectorcallArgs() {
+    for (size_t i = 1; i <= len; i++) Py_XDECREF(args[i]);
+  }
+};
+
 struct EnvContext {
   Napi::FunctionReference *pyObj;
-  std::map<PyObject *, PyObjectWrap *> object_store;
-  std::map<PyObject *, Napi::FunctionReference *> function_store;
+  // The JS Map constructor and methods, used by _FromJS (fromjs.cc)
+  struct {
+    Napi::FunctionReference *cons;
+    Napi::FunctionReference *get;
+    Napi::FunctionReference *set;
+  } js_map;
+  // Buffer.from, used for the shared buffers (tojs.cc)
+  Napi::FunctionReference *buffer_from;
+  // The Proxy constructor and the handler of the lazy conversions (lazy.cc)
+  Napi::FunctionReference *proxy;
+  Napi::ObjectReference *lazy_handler = nullptr;
+  PyObjectMap<PyObjectWrap *> object_store;
+  PyObjectMap<Napi::FunctionReference *> function_store;
   // There are two destruction paths for TSFNs:
   // * death by JSCall_Trampoline_Finalizer - when the object is GCed
   // * death by napi_async_cleanup_hook - when the environment shuts down before the GC
   // https://github.com/nodejs/node/pull/45903
   std::set<Napi::ThreadSafeFunction *> tsfn_store;
+  // All the live JSCall_Trampolines of this environment, used by the cycle collector
+  // This one is protected by the GIL as the trampolines can be destroyed in any thread
+  std::set<PyObject *> trampoline_store;
+  // Python buffers exported by toJS({buffer: 'shared'}), indexed by memory address (tojs.cc)
+  // V8 does not support multiple ArrayBuffers over the same memory, so every address is
+  // exported only once and the following exports reuse the same ArrayBuffer
+  struct SharedBuffer {
+    Napi::Reference<Napi::ArrayBuffer> *ref;
+    Py_buffer *view;
+  };
+  std::map<void *, SharedBuffer> shared_buffers;
+  // The interned names used by callMethod() (call.cc)
+  std::map<std::string, PyStrongRef> method_names;
+  // Memoized conversions of the immutable objects, enabled by memoCache() (memo.cc)
+  struct {
+    bool enabled = false;
+    PyObjectMap<napi_ref> entries;
+    size_t hits = 0;
+    size_t misses = 0;
+  } memo;
+  // Python heap reported as external memory in TRACEMALLOC mode (memory.cc)
+  int64_t traced_memory = 0;
+  size_t traced_memory_countdown = 0;
   // There is one V8 main thread per environment (EnvContext) and only one main Python thread (main.cc)
   std::thread::id v8_main;
+  napi_env env;
   // libuv queue for running lambdas on the V8 main thread
   struct {
     uv_async_t *handle;
     std::queue<std::function<void()>> jobs;
     std::mutex lock;
   } v8_queue;
+  // Fire-and-forget calls of JS functions, run in batches on the V8 main thread (call.cc)
+  // The lock is always acquired after the GIL
+  struct JSAsyncCall {
+    PyObject *fn;
+    PyObject *args;
+    PyObject *kw;
+  };
+  struct {
+    uv_async_t *handle;
+    napi_env env;
+    std::vector<JSAsyncCall> calls;
+    std::mutex lock;
+    // Signaled when the queue is drained or closed
+    std::condition_variable space;
+    // Set by the cleanup hook, the new calls are dropped
+    bool closed;
+  } js_async;
 
 #ifdef DEBUG
   ~EnvContext() {
@@ -241,3 +498,7 @@ class PyGILGuard {
 #if PY_MAJOR_VERSION < 3 || (PY_MAJOR_VERSION == 3 && PY_MINOR_VERSION < 8)
 #error Python 3.8 is required
 #endif
+
+#if PY_MAJOR_VERSION == 3 && PY_MINOR_VERSION < 9
+#define PyObject_Vectorcall _PyObject_Vectorcall
+#endif
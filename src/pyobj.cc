@@ -1,11 +1,13 @@
 #include "pymport.h"
 #include "pystackobject.h"
 #include "values.h"
+#include "release.h"
+#include "memory.h"
 
 using namespace Napi;
 using namespace pymport;
 
-PyObjectWrap::PyObjectWrap(const CallbackInfo &info) : ObjectWrap(info), self(nullptr), memory_hint(0) {
+PyObjectWrap::PyObjectWrap(const CallbackInfo &info) : ObjectWrap(info), self(nullptr), memory_hint(0), cycle_anchor(false) {
   Napi::Env env = info.Env();
   // There are two ways to get here:
   // * when called directly from JavaScript we throw
@@ -17,7 +19,7 @@ PyObjectWrap::PyObjectWrap(const CallbackInfo &info) : ObjectWrap(info), self(nu
 
   if (info[0].IsExternal()) {
     self = PyStrongRef(info[0].As<External<PyObject>>().Data());
-    memory_hint = PyObject_LengthHint(*self, sizeof(PyObject));
+    if (memory::mode == memory::ESTIMATE) memory_hint = memory::Estimate(*self);
     if (memory_hint > 0) Napi::MemoryManagement::AdjustExternalMemory(env, static_cast<int64_t>(memory_hint));
   } else {
     // Reference unicity cannot be achieved with a constructor
@@ -39,8 +41,23 @@ void PyObjectWrap::Finalize(Napi::BasicEnv env) {
     return;
   }
 
+  if (release::background) {
+    // The object store is accessed only from the V8 main thread and does not need the GIL,
+    // the reference is released by the background release thread
+#ifdef DEBUG
+    // The debug logging prints the Python objects
+    PyGILGuard pyGILGuard;
+#endif
+    if (*self != nullptr) {
+      Release();
+      release::Enqueue(self.gift());
+    }
+    return;
+  }
+
   // This is, in fact, a function that is called from a JavaScript context
-  // TODO: this can block the event loop with long-running Python operations
+  // This can block the event loop with long-running Python operations
+  // (the background release mode avoids it)
   PyGILGuard pyGILGuard;
   ASSERT(active_environments > 0);
 
@@ -57,23 +74,31 @@ void PyObjectWrap::Finalize(Napi::BasicEnv env) {
 PyObjectWrap::~PyObjectWrap() {
 }
 
+// The methods that can run Python code on the object are Touched, refer to cycles.cc
 Function PyObjectWrap::GetClass(Napi::Env env) {
   return DefineClass(
     env,
     "PyObject",
-    {PyObjectWrap::InstanceMethod("toString", &PyObjectWrap::ToString),
-     PyObjectWrap::InstanceMethod("get", &PyObjectWrap::Get),
-     PyObjectWrap::InstanceMethod("has", &PyObjectWrap::Has),
-     PyObjectWrap::InstanceMethod("item", &PyObjectWrap::Item),
-     PyObjectWrap::InstanceMethod("call", &PyObjectWrap::Call),
-     PyObjectWrap::InstanceMethod("callAsync", &PyObjectWrap::CallAsync),
-     PyObjectWrap::InstanceMethod("toJS", &PyObjectWrap::ToJS),
-     PyObjectWrap::InstanceMethod("valueOf", &PyObjectWrap::ToJS),
+    {PyObjectWrap::InstanceMethod("toString", &PyObjectWrap::Touched<&PyObjectWrap::ToString>),
+     PyObjectWrap::InstanceMethod("get", &PyObjectWrap::Touched<&PyObjectWrap::Get>),
+     PyObjectWrap::InstanceMethod("has", &PyObjectWrap::Touched<&PyObjectWrap::Has>),
+     PyObjectWrap::InstanceMethod("item", &PyObjectWrap::Touched<&PyObjectWrap::Item>),
+     PyObjectWrap::InstanceMethod("call", &PyObjectWrap::Touched<&PyObjectWrap::Call>),
+     PyObjectWrap::InstanceMethod("callAsync", &PyObjectWrap::Touched<&PyObjectWrap::CallAsync>),
+     PyObjectWrap::InstanceMethod("callMethod", &PyObjectWrap::Touched<&PyObjectWrap::CallMethod>),
+     PyObjectWrap::InstanceMethod("callMany", &PyObjectWrap::Touched<&PyObjectWrap::CallMany>),
+     PyObjectWrap::InstanceMethod("callManyAsync", &PyObjectWrap::Touched<&PyObjectWrap::CallManyAsync>),
+     PyObjectWrap::InstanceMethod("callMethodAsync", &PyObjectWrap::Touched<&PyObjectWrap::CallMethodAsync>),
+     PyObjectWrap::InstanceMethod("nextAsync", &PyObjectWrap::Touched<&PyObjectWrap::NextAsync>),
+     PyObjectWrap::InstanceMethod("toJS", &PyObjectWrap::Touched<&PyObjectWrap::ToJS>),
+     PyObjectWrap::InstanceMethod("valueOf", &PyObjectWrap::Touched<&PyObjectWrap::ToJS>),
+     PyObjectWrap::InstanceMethod("toTypedArray", &PyObjectWrap::Touched<&PyObjectWrap::ToTypedArray>),
+     PyObjectWrap::InstanceMethod("toColumns", &PyObjectWrap::Touched<&PyObjectWrap::ToColumns>),
      PyObjectWrap::InstanceAccessor("id", &PyObjectWrap::Id, nullptr),
      PyObjectWrap::InstanceAccessor("type", &PyObjectWrap::Type, nullptr),
      PyObjectWrap::InstanceAccessor("callable", &PyObjectWrap::Callable, nullptr),
-     PyObjectWrap::InstanceAccessor("length", &PyObjectWrap::Length, nullptr),
-     PyObjectWrap::InstanceAccessor("constr", &PyObjectWrap::Constructor, nullptr),
+     PyObjectWrap::InstanceAccessor("length", &PyObjectWrap::Touched<&PyObjectWrap::Length>, nullptr),
+     PyObjectWrap::InstanceAccessor("constr", &PyObjectWrap::Touched<&PyObjectWrap::Constructor>, nullptr),
      PyObjectWrap::StaticMethod("keys", &PyObjectWrap::Keys),
      PyObjectWrap::StaticMethod("values", &PyObjectWrap::Values),
      PyObjectWrap::StaticMethod("fromJS", &PyObjectWrap::FromJS),
@@ -82,6 +107,7 @@ Function PyObjectWrap::GetClass(Napi::Env env) {
      PyObjectWrap::StaticMethod("float", &PyObjectWrap::Float),
      PyObjectWrap::StaticMethod("dict", &PyObjectWrap::Dictionary),
      PyObjectWrap::StaticMethod("list", &PyObjectWrap::List),
+     PyObjectWrap::StaticMethod("array", &PyObjectWrap::NumberArray),
      PyObjectWrap::StaticMethod("tuple", &PyObjectWrap::Tuple),
      PyObjectWrap::StaticMethod("slice", &PyObjectWrap::Slice),
      PyObjectWrap::StaticMethod("set", &PyObjectWrap::Set),
@@ -89,7 +115,8 @@ Function PyObjectWrap::GetClass(Napi::Env env) {
      PyObjectWrap::StaticMethod("bytes", &PyObjectWrap::Bytes),
      PyObjectWrap::StaticMethod("bytearray", &PyObjectWrap::ByteArray),
      PyObjectWrap::StaticMethod("memoryview", &PyObjectWrap::MemoryView),
-     PyObjectWrap::StaticMethod("func", &PyObjectWrap::Functor)});
+     PyObjectWrap::StaticMethod("func", &PyObjectWrap::Functor),
+     PyObjectWrap::StaticMethod("compileConverter", &PyObjectWrap::CompileConverter)});
 }
 
 Value PyObjectWrap::ToString(const CallbackInfo &info) {
@@ -98,7 +125,7 @@ Value PyObjectWrap::ToString(const CallbackInfo &info) {
 
   PyStrongRef r = PyObject_Str(*self);
   EXCEPTION_CHECK(env, r);
-  return ToJS(env, r, {1, false});
+  return ToJS(env, r, {1, false, false});
 }
 
 Value PyObjectWrap::Id(const CallbackInfo &info) {
@@ -111,6 +138,7 @@ Value PyObjectWrap::Id(const CallbackInfo &info) {
 Value PyObjectWrap::Get(const CallbackInfo &info) {
   Napi::Env env = info.Env();
   PyGILGuard pyGilGuard;
+  UpdateMemoryHint(env);
 
   std::string name = NAPI_ARG_STRING(0).Utf8Value();
   PyStrongRef r = PyObject_GetAttrString(*self, name.c_str());
@@ -166,6 +194,7 @@ Value PyObjectWrap::Constructor(const CallbackInfo &info) {
 Value PyObjectWrap::Item(const CallbackInfo &info) {
   Napi::Env env = info.Env();
   PyGILGuard pyGilGuard;
+  UpdateMemoryHint(env);
 
   if (info.Length() < 1) throw Error::New(env, "Missing mandatory argument");
   PyStrongRef item = FromJS(info[0]);
@@ -183,6 +212,7 @@ Value PyObjectWrap::Keys(const CallbackInfo &info) {
 
   Object target = NAPI_ARG_PYOBJECT(0);
   auto py = ObjectWrap::Unwrap(target);
+  py->Touch(env);
 
   if (PyMapping_Check(*py->self)) return New(env, PyMapping_Keys(*py->self));
 
@@ -195,6 +225,7 @@ Value PyObjectWrap::Values(const CallbackInfo &info) {
 
   Object target = NAPI_ARG_PYOBJECT(0);
   auto py = ObjectWrap::Unwrap(target);
+  py->Touch(env);
 
   if (PyMapping_Check(*py->self)) return New(env, PyMapping_Values(*py->self));
 
@@ -204,6 +235,7 @@ Value PyObjectWrap::Values(const CallbackInfo &info) {
 Value PyObjectWrap::Length(const CallbackInfo &info) {
   Napi::Env env = info.Env();
   PyGILGuard pyGilGuard;
+  UpdateMemoryHint(env);
 
   if (PySequence_Check(*self)) return Number::New(env, static_cast<long>(PySequence_Size(*self)));
   if (PyMapping_Check(*self)) return Number::New(env, static_cast<long>(PyMapping_Size(*self)));
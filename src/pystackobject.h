@@ -13,6 +13,7 @@
 
 // These two classes express the Strong/Weak reference rules
 // with C++ semantics
+// They are not polymorphic and have the size of a pointer
 
 namespace pymport {
 
@@ -59,7 +60,7 @@ class PyWeakRef {
     return self;
   };
 
-  INLINE virtual PyObject **operator&() {
+  INLINE PyObject **operator&() {
     return &self;
   }
 };
@@ -136,12 +137,12 @@ class PyStrongRef : public PyWeakRef {
   };
 
   // Overwriting existing references is supported only on WeakRefs
-  INLINE virtual PyObject **operator&() override {
+  INLINE PyObject **operator&() {
     ASSERT(self == nullptr);
     return &self;
   }
 
-  INLINE virtual ~PyStrongRef() {
+  INLINE ~PyStrongRef() {
     if (active_environments == 0) {
       VERBOSE(INIT, "Dereference running after environment cleanup: %p\n", self);
       return;
@@ -154,4 +155,6 @@ class PyStrongRef : public PyWeakRef {
   };
 };
 
+static_assert(sizeof(PyStrongRef) == sizeof(PyObject *), "PyStrongRef must be pointer-sized");
+
 } // namespace pymport
@@ -0,0 +1,131 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "pymport.h"
+#include "pystackobject.h"
+#include "values.h"
+#include "release.h"
+
+using namespace pymport;
+
+// This is the background release thread
+// There is only one Python interpreter, so there is only one queue shared
+// by all environments
+//
+// The queue is a lock-free singly-linked stack:
+// * producers (V8 finalizers, one V8 main thread per environment) push with a CAS
+// * the consumer takes the whole stack with a single exchange, which is
+//   both ABA-free and naturally batched
+// The order of the decrefs is not significant
+// The mutex/condvar are used only to wake up the consumer when the
+// queue goes from empty to non-empty
+namespace {
+
+struct Node {
+  PyObject *obj;
+  Node *next;
+};
+
+std::atomic<Node *> head{nullptr};
+std::atomic<size_t> depth{0};
+std::atomic<uint64_t> released{0};
+std::atomic<uint64_t> batches{0};
+std::atomic<uint64_t> last_drain_us{0};
+std::atomic<uint64_t> max_drain_us{0};
+
+std::mutex wakeup_lock;
+std::condition_variable wakeup;
+bool stopping = false;
+std::thread *drainer = nullptr;
+
+// Called with the GIL held
+void Drain(Node *batch) {
+  size_t n = 0;
+  while (batch != nullptr) {
+    Node *next = batch->next;
+    VERBOSE(REFS, "Background release %p\n", batch->obj);
+    Py_DECREF(batch->obj);
+    delete batch;
+    batch = next;
+    n++;
+  }
+  depth -= n;
+  released += n;
+}
+
+void DrainLoop() {
+  VERBOSE(
+    INIT,
+    "Background release thread started %lu\n",
+    static_cast<unsigned long>(std::hash<std::thread::id>{}(std::this_thread::get_id())));
+  while (true) {
+    {
+      std::unique_lock<std::mutex> guard(wakeup_lock);
+      wakeup.wait(guard, [] { return stopping || head.load() != nullptr; });
+    }
+
+    Node *batch = head.exchange(nullptr);
+    if (batch != nullptr) {
+      auto start = std::chrono::steady_clock::now();
+      {
+        PyGILGuard pyGilGuard;
+        Drain(batch);
+      }
+      uint64_t us = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+      batches++;
+      last_drain_us = us;
+      uint64_t max = max_drain_us.load();
+      while (us > max && !max_drain_us.compare_exchange_weak(max, us)) {}
+      continue;
+    }
+
+    std::lock_guard<std::mutex> guard(wakeup_lock);
+    if (stopping) break;
+  }
+  VERBOSE(INIT, "Background release thread exiting\n");
+}
+
+} // namespace
+
+std::atomic<bool> release::background{false};
+
+void release::Enqueue(PyObject *obj) {
+  Node *node = new Node{obj, head.load(std::memory_order_relaxed)};
+  depth++;
+  while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {}
+  if (node->next == nullptr) {
+    // The queue was empty, the consumer might be sleeping
+    std::lock_guard<std::mutex> guard(wakeup_lock);
+    wakeup.notify_one();
+  }
+}
+
+// Called after initializing Python
+void release::Init() {
+  ASSERT(drainer == nullptr);
+  stopping = false;
+  drainer = new std::thread(DrainLoop);
+}
+
+// Called before shutting down Python, without holding the GIL
+// Releases all the remaining references
+void release::Shutdown() {
+  if (drainer == nullptr) return;
+  {
+    std::lock_guard<std::mutex> guard(wakeup_lock);
+    stopping = true;
+    wakeup.notify_one();
+  }
+  drainer->join();
+  delete drainer;
+  drainer = nullptr;
+  ASSERT(head.load() == nullptr);
+}
+
+release::Stats release::GetStats() {
+  return {depth.load(), released.load(), batches.load(), last_drain_us.load(), max_drain_us.load()};
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <atomic>
+#include "values.h"
+#include "pystackobject.h"
+
+namespace pymport {
+namespace release {
+
+// Background release of Python references
+// When enabled, the V8 finalizers do not obtain the GIL, they push the
+// references onto a lock-free queue that is drained by a dedicated Python thread
+extern std::atomic<bool> background;
+
+extern void Init();
+extern void Shutdown();
+// Steals the reference, can be called without the GIL
+extern void Enqueue(PyObject *);
+
+struct Stats {
+  // References waiting in the queue
+  size_t depth;
+  // Total references released by the background thread
+  uint64_t released;
+  // Number of batches (GIL acquisitions)
+  uint64_t batches;
+  // Drain time of the last batch and the slowest batch in microseconds
+  // (includes waiting for the GIL)
+  uint64_t last_drain_us;
+  uint64_t max_drain_us;
+};
+extern Stats GetStats();
+
+}; // namespace release
+}; // namespace pymport
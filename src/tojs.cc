@@ -1,5 +1,7 @@
 #include <cmath>
-#include <map>
+#include <cstring>
+#include <memory>
+#include <vector>
 #include "pymport.h"
 #include "pystackobject.h"
 #include "values.h"
@@ -7,16 +9,126 @@
 using namespace Napi;
 using namespace pymport;
 
+// The conversion does not recurse on the native stack, the containers are converted
+// by an explicit work stack:
+// * every container is created empty when it is first encountered, it is immediately
+//   stored in its parent and a frame that will fill it is pushed on the stack
+// * every step converts one element of the container on top of the stack
+// * the visited set breaks the recursion on circular and shared references, it contains
+//   only the containers (the scalars are always converted again) and it maps them to their
+//   index in a JS array that keeps them alive - this way the steps can run in short-lived
+//   handle scopes that are recycled every tojs_chunk steps and the memory used by the
+//   local handles remains bounded no matter how large the result is
+static constexpr size_t tojs_chunk = 4096;
+
+struct PyObjectWrap::ToJSFrame {
+  enum Kind { LIST, TUPLE, DICT, SET, DIR } kind;
+  // The container, the frame keeps it alive
+  PyStrongRef py;
+  // The iterator of a set or the attribute names of a module
+  PyStrongRef aux;
+  // Index in ToJSState::containers
+  uint32_t index;
+  // The JS container, valid only in the handle scope of the generation gen
+  napi_value js;
+  uint32_t gen;
+  // Next element to convert (PyDict_Next position for the dictionaries)
+  Py_ssize_t pos;
+  // Next JS index for the sets
+  uint32_t next;
+  // Conversion options of the elements
+  ToJSOpts opts;
+  // Lists of records: the tuple of the Python keys, the index in ToJSState::containers
+  // of the array of the converted keys and their handles, valid in the generation gen
+  PyStrongRef shape;
+  uint32_t shape_index;
+  std::vector<napi_value> keys;
+  // A tuple or a frozenset that has contained only immutable elements so far (refer to memo.cc)
+  bool immutable;
+
+  ToJSFrame(Kind kind, PyStrongRef &&py, PyStrongRef &&aux, uint32_t index, napi_value js, uint32_t gen, ToJSOpts opts)
+    : kind(kind),
+      py(std::move(py)),
+      aux(std::move(aux)),
+      index(index),
+      js(js),
+      gen(gen),
+      pos(0),
+      next(0),
+      opts(opts),
+      shape(nullptr),
+      shape_index(0),
+      immutable(false) {
+  }
+};
+
+struct PyObjectWrap::ToJSState {
+  // Both are created with the first container
+  Napi::Array containers;
+  std::unique_ptr<PyObjectMap<uint32_t>> visited;
+  std::vector<ToJSFrame> stack;
+  // Incremented every time the handle scope is recycled
+  uint32_t generation;
+  // The keys of the dictionaries are converted by a separate nested engine
+  bool nested;
+  // The memo cache is enabled
+  bool memo;
+  // Scratch space of the records
+  std::vector<napi_property_descriptor> props;
+  std::vector<PyObject *> values;
+
+  ToJSState(bool nested, bool memo) : generation(0), nested(nested), memo(memo) {
+  }
+
+  // The frame on top of the stack is complete
+  // An immutable container is memoized, a mutable one makes its parent mutable
+  void Pop(Napi::Env env) {
+    ToJSFrame &frame = stack.back();
+    bool immutable = frame.immutable;
+    if (immutable) _ToJS_MemoStore(env, frame.py, Napi::Value(env, frame.js));
+    stack.pop_back();
+    if (!immutable && !stack.empty()) stack.back().immutable = false;
+  }
+
+  // An element of the container on top of the stack has been converted, when the
+  // element is a new container, its own frame is on top and will report on completion
+  void Element(Napi::Env env, const PyWeakRef &py, size_t depth) {
+    if (stack.size() != depth) return;
+    ToJSFrame &frame = stack.back();
+    if (frame.immutable && !_ToJS_MemoElement(env, py)) frame.immutable = false;
+  }
+
+  // Keeps a JS value alive until the end of the conversion, returns its index
+  uint32_t Keep(Napi::Env env, Napi::Value v) {
+    // The first container is the top-level object, the array of the containers
+    // is created in the outer scope of the conversion
+    if (visited == nullptr) {
+      containers = Array::New(env);
+      visited = std::make_unique<PyObjectMap<uint32_t>>();
+    }
+    uint32_t index = containers.Length();
+    containers.Set(index, v);
+    return index;
+  }
+
+  // Returns an empty value if the container has not been converted yet
+  Napi::Value Find(PyObject *py) {
+    if (visited == nullptr) return Napi::Value();
+    uint32_t *existing = visited->find(py);
+    if (existing == nullptr) return Napi::Value();
+    return containers.Get(*existing);
+  }
+
+  void Visit(Napi::Env env, PyObject *py, Napi::Value v) {
+    uint32_t index = Keep(env, v);
+    visited->insert(py, index);
+  }
+};
+
 // _ToJS expects a borrowed reference
-Napi::Value PyObjectWrap::_ToJS(Napi::Env env, const PyWeakRef &py, NapiObjectStore &store, ToJSOpts opts) {
+// The containers are returned empty, they are filled by the following steps
+Napi::Value PyObjectWrap::_ToJS(Napi::Env env, const PyWeakRef &py, ToJSState &state, ToJSOpts opts) {
   if (opts.depth == 0) return New(env, PyStrongRef(py));
-  // This is a temporary store that breaks recursion, it keeps tracks of the locally
-  // created Napi::Objects for each PyObject and if one is encountered multiple times,
-  // then it is replaced by the same reference
-  // This also means that the recursion must use a single Napi::HandleScope because these
-  // are stack-allocated local references
-  auto existing = store.find(*py);
-  if (existing != store.end()) { return existing->second; }
 
   // Fixed values before anything else
   // Especially since PyLong_Check succeeds for booleans
@@ -32,172 +144,455 @@ Napi::Value PyObjectWrap::_ToJS(Napi::Env env, const PyWeakRef &py, NapiObjectSt
 
   if (PyFloat_Check(*py)) { return Number::New(env, PyFloat_AsDouble(*py)); }
 
-  if (PyList_Check(*py)) { return _ToJS_List(env, py, store, opts); }
+  if (PyUnicode_Check(*py)) { return _ToJS_String(env, py); }
 
-  if (PyUnicode_Check(*py)) {
-    PyStrongRef utf16 = PyUnicode_AsUTF16String(*py);
-    EXCEPTION_CHECK(env, utf16);
-    auto raw = PyBytes_AsString(*utf16);
-    EXCEPTION_CHECK(env, static_cast<int>(raw == nullptr));
-    return String::New(env, reinterpret_cast<char16_t *>(raw + 2), PyUnicode_GET_LENGTH(*py));
+  bool memoizable = state.memo && opts.depth < 0 && (PyTuple_CheckExact(*py) || PyFrozenSet_CheckExact(*py));
+  if (memoizable) {
+    Napi::Value memo = _ToJS_MemoFind(env, py);
+    if (!memo.IsEmpty()) return memo;
   }
 
-  if (PyDict_Check(*py)) { return _ToJS_Dictionary(env, py, store, opts); }
-
-  if (PyTuple_Check(*py)) { return _ToJS_Tuple(env, py, store, opts); }
+  ToJSFrame::Kind kind;
+  if (PyList_Check(*py))
+    kind = ToJSFrame::LIST;
+  else if (PyDict_Check(*py))
+    kind = ToJSFrame::DICT;
+  else if (PyTuple_Check(*py))
+    kind = ToJSFrame::TUPLE;
+  else if (PyAnySet_Check(*py))
+    kind = ToJSFrame::SET;
+  else if (PyModule_Check(*py))
+    kind = ToJSFrame::DIR;
+  else {
+    if (PyObject_Type(*py) == *JSCall_Trampoline_Type) { return _ToJS_JSFunction(env, py); }
+
+    // Only the top-level object can be copied without the GIL - when converting the
+    // elements of a container, other Python threads could invalidate the borrowed references
+    bool top = !state.nested && state.visited == nullptr;
+    if (opts.buffer && PyObject_CheckBuffer(*py)) { return _ToJS_Buffer(env, py, opts, top); }
+
+    // Everything else is kept as a PyObject
+    // (New/NewCallable expect a strong reference and steal it)
+    PyStrongRef strong(py);
+    if (PyCallable_Check(*py)) { return NewCallable(env, std::move(strong)); }
+    return New(env, std::move(strong));
+  }
 
-  if (PyAnySet_Check(*py)) { return _ToJS_Set(env, py, store, opts); }
+  Napi::Value existing = state.Find(*py);
+  if (!existing.IsEmpty()) return existing;
+
+  PyStrongRef aux = nullptr;
+  Napi::Object r;
+  switch (kind) {
+    case ToJSFrame::LIST:
+    case ToJSFrame::TUPLE:
+      r = Array::New(env);
+      break;
+    case ToJSFrame::SET:
+      r = Array::New(env);
+      aux = PyObject_GetIter(*py);
+      EXCEPTION_CHECK(env, aux);
+      break;
+    case ToJSFrame::DIR:
+      r = Object::New(env);
+      aux = PyObject_Dir(*py);
+      // It seems that some system modules are hidden, we return an empty object
+      if (aux == nullptr) {
+        PyErr_Clear();
+        return r;
+      }
+      break;
+    default:
+      r = Object::New(env);
+  }
 
-  if (PyModule_Check(*py)) { return _ToJS_Dir(env, py, store, opts); }
+  uint32_t index = state.Keep(env, r);
+  state.visited->insert(*py, index);
+  state.stack.emplace_back(kind, PyStrongRef(py), std::move(aux), index, r, state.generation, opts);
+  state.stack.back().opts.depth--;
+  state.stack.back().immutable = memoizable;
+  // The elements of a list of records are dictionaries
+  if (kind == ToJSFrame::LIST && opts.depth != 1) _ToJS_Shape(env, state, state.stack.back());
+  return r;
+}
 
-  if (PyObject_Type(*py) == *JSCall_Trampoline_Type) { return _ToJS_JSFunction(env, py); }
+// Two keys of records, the keys of dictionaries built by the same code are usually
+// the same interned strings
+static inline bool SameKey(PyObject *a, PyObject *b) {
+  return a == b || (PyUnicode_CheckExact(a) && PyUnicode_Compare(a, b) == 0);
+}
 
-  if (opts.buffer && PyObject_CheckBuffer(*py)) { return _ToJS_Buffer(env, py, store); }
+// Lists of dictionaries with the same keys (DB rows, pandas.DataFrame.to_dict('records')...)
+// are converted from a template - the keys are converted only once and every JS object
+// is created with all of its properties at once, sharing the same hidden class
+// The first two elements decide if the list looks like a list of records, every
+// element is checked when it is converted and those that do not match are converted
+// as usual
+void PyObjectWrap::_ToJS_Shape(Napi::Env env, ToJSState &state, ToJSFrame &frame) {
+  if (PyList_GET_SIZE(*frame.py) < 2) return;
+  PyObject *first = PyList_GET_ITEM(*frame.py, 0);
+  PyObject *second = PyList_GET_ITEM(*frame.py, 1);
+  if (!PyDict_CheckExact(first) || !PyDict_CheckExact(second) || first == second) return;
+  Py_ssize_t n = PyDict_GET_SIZE(first);
+  if (n == 0 || PyDict_GET_SIZE(second) != n) return;
+
+  PyStrongRef shape = PyTuple_New(n);
+  EXCEPTION_CHECK(env, shape);
+  PyObject *key, *value;
+  Py_ssize_t pos = 0, i = 0;
+  while (PyDict_Next(first, &pos, &key, &value)) {
+    if (!PyUnicode_CheckExact(key)) return;
+    Py_INCREF(key);
+    PyTuple_SET_ITEM(*shape, i++, key);
+  }
+  pos = 0;
+  i = 0;
+  while (PyDict_Next(second, &pos, &key, &value)) {
+    if (!SameKey(key, PyTuple_GET_ITEM(*shape, i++))) return;
+  }
 
-  // Everything else is kept as a PyObject
-  // (New/NewCallable expect a strong reference and steal it)
-  PyStrongRef strong(py);
-  if (PyCallable_Check(*py)) { return NewCallable(env, std::move(strong)); }
-  return New(env, std::move(strong));
+  Napi::Array keys = Array::New(env, n);
+  frame.keys.resize(n);
+  for (i = 0; i < n; i++) {
+    Napi::Value js = _ToJS_String(env, PyTuple_GET_ITEM(*shape, i));
+    keys.Set(static_cast<uint32_t>(i), js);
+    frame.keys[i] = js;
+  }
+  frame.shape_index = state.Keep(env, keys);
+  frame.shape = std::move(shape);
 }
 
-Napi::Value PyObjectWrap::_ToJS_Dictionary(Napi::Env env, const PyWeakRef &py, NapiObjectStore &store, ToJSOpts opts) {
-  auto obj = Object::New(env);
+// Converts an element of a list of records, returns an empty value if it does not match
+// The frame reference is not valid after the call
+Napi::Value PyObjectWrap::_ToJS_Record(Napi::Env env, ToJSState &state, ToJSFrame &frame, const PyWeakRef &row) {
+  if (!PyDict_CheckExact(*row)) return Napi::Value();
+  size_t n = frame.keys.size();
+  if (static_cast<size_t>(PyDict_GET_SIZE(*row)) != n) return Napi::Value();
 
-  PyWeakRef key = nullptr, value = nullptr;
+  state.props.resize(n);
+  state.values.resize(n);
+  PyObject *key, *value;
   Py_ssize_t pos = 0;
-  store.insert({*py, obj});
-  while (PyDict_Next(*py, &pos, &key, &value)) {
-    auto jsKey = _ToJS(env, key, store, {opts.depth - 1, opts.buffer});
-    auto jsValue = _ToJS(env, value, store, {opts.depth - 1, opts.buffer});
+  size_t i = 0;
+  while (PyDict_Next(*row, &pos, &key, &value)) {
+    if (!SameKey(key, PyTuple_GET_ITEM(*frame.shape, i))) return Napi::Value();
+    state.props[i] = {nullptr, frame.keys[i], nullptr, nullptr, nullptr, nullptr, napi_default, nullptr};
+    state.props[i].attributes =
+      static_cast<napi_property_attributes>(napi_writable | napi_enumerable | napi_configurable);
+    state.values[i] = value;
+    i++;
+  }
+
+  Napi::Value existing = state.Find(*row);
+  if (!existing.IsEmpty()) return existing;
+
+  ToJSOpts opts = frame.opts;
+  opts.depth--;
+  Object r = Object::New(env);
+  state.Visit(env, *row, r);
+  // The values that are containers are filled by the following steps
+  for (i = 0; i < n; i++) state.props[i].value = _ToJS(env, state.values[i], state, opts);
+  napi_status status = napi_define_properties(env, r, n, state.props.data());
+  if (status != napi_ok) throw Error::New(env);
+  return r;
+}
+
+// Container keys (tuples and frozensets) are coerced to strings and must be complete
+// before being used, they are converted by a nested engine
+Napi::Value PyObjectWrap::_ToJS_Key(Napi::Env env, const PyWeakRef &key, ToJSState &state, ToJSOpts opts) {
+  if (opts.depth != 0 && (PyTuple_Check(*key) || PyAnySet_Check(*key))) return _ToJS_Run(env, key, opts, true);
+  return _ToJS(env, key, state, opts);
+}
+
+// Converts one element of the container on top of the stack
+// The frame reference is not valid after _ToJS, it can push a new frame
+void PyObjectWrap::_ToJS_Step(Napi::Env env, ToJSState &state) {
+  ToJSFrame &frame = state.stack.back();
+  if (frame.gen != state.generation) {
+    frame.js = state.containers.Get(frame.index);
+    if (frame.shape != nullptr) {
+      Napi::Array keys = state.containers.Get(frame.shape_index).As<Napi::Array>();
+      for (uint32_t i = 0; i < frame.keys.size(); i++) frame.keys[i] = keys.Get(i);
+    }
+    frame.gen = state.generation;
+  }
+  Napi::Object r(env, frame.js);
+  ToJSOpts opts = frame.opts;
+
+  switch (frame.kind) {
+    case ToJSFrame::LIST:
+    case ToJSFrame::TUPLE: {
+      Py_ssize_t len = frame.kind == ToJSFrame::LIST ? PyList_GET_SIZE(*frame.py) : PyTuple_GET_SIZE(*frame.py);
+      if (frame.pos >= len) {
+        state.Pop(env);
+        return;
+      }
+      uint32_t i = static_cast<uint32_t>(frame.pos++);
+      PyWeakRef v = frame.kind == ToJSFrame::LIST ? PyList_GET_ITEM(*frame.py, i) : PyTuple_GET_ITEM(*frame.py, i);
+      Napi::Value js;
+      if (frame.shape != nullptr) js = _ToJS_Record(env, state, frame, v);
+      if (js.IsEmpty()) {
+        size_t depth = state.stack.size();
+        js = _ToJS(env, v, state, opts);
+        state.Element(env, v, depth);
+      }
+      r.Set(i, js);
+      return;
+    }
+
+    case ToJSFrame::SET: {
+      PyStrongRef item = PyIter_Next(*frame.aux);
+      if (item == nullptr) {
+        EXCEPTION_CHECK(env, static_cast<int>(PyErr_Occurred() != nullptr));
+        state.Pop(env);
+        return;
+      }
+      uint32_t i = frame.next++;
+      size_t depth = state.stack.size();
+      r.Set(i, _ToJS(env, item, state, opts));
+      state.Element(env, item, depth);
+      return;
+    }
+
+    case ToJSFrame::DICT: {
+      PyWeakRef key = nullptr, value = nullptr;
+      if (!PyDict_Next(*frame.py, &frame.pos, &key, &value)) {
+        state.Pop(env);
+        return;
+      }
+      // The frame keeps the dictionary alive, but not its elements
+      PyStrongRef strong_value(value);
+      auto jsKey = _ToJS_Key(env, key, state, opts);
+      auto jsValue = _ToJS(env, value, state, opts);
 // Remember to drop this kludge if/when Python+numpy behavior is different
 #if PY_MAJOR_VERSION == 3 && PY_MINOR_VERSION == 13
-    try {
+      try {
 #endif
-      obj.Set(jsKey, jsValue);
+        r.Set(jsKey, jsValue);
 #if PY_MAJOR_VERSION == 3 && PY_MINOR_VERSION == 13
-    } catch (const Error &err) {
-      fprintf(
-        stderr,
-        "Warning, cannot convert dictionary key to string, ignoring element. "
-        "See https://github.com/mmomtchev/pymport/issues/338\n"
-        "Faulty element value is (key of type ");
-      PyObject_Print((PyObject *)(*value)->ob_type, stderr, 0);
-      fprintf(stderr, " is not printable): ");
-      PyObject_Print(*value, stderr, 0);
-      fprintf(stderr, "\n");
-    }
+      } catch (const Error &err) {
+        fprintf(
+          stderr,
+          "Warning, cannot convert dictionary key to string, ignoring element. "
+          "See https://github.com/mmomtchev/pymport/issues/338\n"
+          "Faulty element value is (key of type ");
+        PyObject_Print((PyObject *)(*value)->ob_type, stderr, 0);
+        fprintf(stderr, " is not printable): ");
+        PyObject_Print(*value, stderr, 0);
+        fprintf(stderr, "\n");
+      }
 #endif
-  }
-  return obj;
-}
-
-Napi::Value PyObjectWrap::_ToJS_Tuple(Napi::Env env, const PyWeakRef &py, NapiObjectStore &store, ToJSOpts opts) {
-  Napi::Array r = Array::New(env);
-  size_t len = PyTuple_Size(*py);
-  store.insert({*py, r});
+      return;
+    }
 
-  for (size_t i = 0; i < len; i++) {
-    PyWeakRef v = PyTuple_GetItem(*py, i);
-    EXCEPTION_CHECK(env, v);
-    Napi::Value js = _ToJS(env, v, store, {opts.depth - 1, opts.buffer});
-    r.Set(i, js);
+    case ToJSFrame::DIR: {
+      if (frame.pos >= PyList_GET_SIZE(*frame.aux)) {
+        state.Pop(env);
+        return;
+      }
+      // The attribute names list belongs to the frame
+      PyWeakRef key = PyList_GET_ITEM(*frame.aux, frame.pos++);
+      PyStrongRef value = PyObject_GetAttr(*frame.py, *key);
+      // dir(module) can reference modules that are not installed
+      // Typical examples are queue/tkinter or dbm/gdbm
+      // (reading this value leads to an exception in Python too)
+      if (value == nullptr) {
+        PyErr_Clear();
+        return;
+      }
+
+      VERBOSE_PYOBJ(OBJS, *key, "key");
+      Napi::Value jsKey = _ToJS_Key(env, key, state, opts);
+      Napi::Value jsValue = _ToJS(env, value, state, opts);
+      r.Set(jsKey, jsValue);
+      return;
+    }
   }
-  return r;
 }
 
-Napi::Value PyObjectWrap::_ToJS_List(Napi::Env env, const PyWeakRef &py, NapiObjectStore &store, ToJSOpts opts) {
-  Napi::Array r = Array::New(env);
-  size_t len = PyList_Size(*py);
-  store.insert({*py, r});
+Napi::Value PyObjectWrap::_ToJS_Run(Napi::Env env, const PyWeakRef &py, ToJSOpts opts, bool nested) {
+  Napi::EscapableHandleScope scope(env);
+  ToJSState state(nested, env.GetInstanceData<EnvContext>()->memo.enabled);
 
-  for (size_t i = 0; i < len; i++) {
-    PyWeakRef v = PyList_GetItem(*py, i);
-    EXCEPTION_CHECK(env, v);
-    Napi::Value js = _ToJS(env, v, store, {opts.depth - 1, opts.buffer});
-    r.Set(i, js);
+  Napi::Value r = _ToJS(env, py, state, opts);
+  while (!state.stack.empty()) {
+    Napi::HandleScope chunk(env);
+    state.generation++;
+    for (size_t i = 0; i < tojs_chunk && !state.stack.empty(); i++) _ToJS_Step(env, state);
   }
-  return r;
-}
 
-Napi::Value PyObjectWrap::_ToJS_Set(Napi::Env env, const PyWeakRef &py, NapiObjectStore &store, ToJSOpts opts) {
-  auto array = Array::New(env);
-
-  PyStrongRef iter = PyObject_GetIter(*py);
-  store.insert({*py, array});
+  return scope.Escape(r);
+}
 
-  PyStrongRef item = nullptr;
-  size_t i = 0;
-  while ((item = PyIter_Next(*iter)) != nullptr) {
-    array.Set(i, _ToJS(env, item, store, {opts.depth - 1, opts.buffer}));
-    item = nullptr;
-    i++;
+// Python strings are stored in the narrowest possible representation,
+// the 1-byte (latin1) and the 2-byte (UCS-2) kinds are passed directly
+// to V8 without transcoding, only the 4-byte kind needs UTF-16 encoding
+Napi::Value PyObjectWrap::_ToJS_String(Napi::Env env, const PyWeakRef &py) {
+#if PY_VERSION_HEX < 0x030C0000
+  EXCEPTION_CHECK(env, static_cast<int>(PyUnicode_READY(*py) == -1));
+#endif
+  Py_ssize_t len = PyUnicode_GET_LENGTH(*py);
+  napi_value r;
+  napi_status status;
+
+  switch (PyUnicode_KIND(*py)) {
+    case PyUnicode_1BYTE_KIND: {
+      auto raw = reinterpret_cast<char *>(PyUnicode_1BYTE_DATA(*py));
+      status = napi_create_string_latin1(env, raw, len, &r);
+      break;
+    }
+    case PyUnicode_2BYTE_KIND: {
+      auto raw = reinterpret_cast<char16_t *>(PyUnicode_2BYTE_DATA(*py));
+      status = napi_create_string_utf16(env, raw, len, &r);
+      break;
+    }
+    default: {
+      // Characters outside of the BMP are encoded as surrogate pairs,
+      // the UTF-16 length is not the number of code points
+      PyStrongRef utf16 = PyUnicode_AsUTF16String(*py);
+      EXCEPTION_CHECK(env, utf16);
+      auto raw = PyBytes_AsString(*utf16);
+      EXCEPTION_CHECK(env, static_cast<int>(raw == nullptr));
+      // Skip the BOM
+      status = napi_create_string_utf16(
+        env, reinterpret_cast<char16_t *>(raw + 2), PyBytes_GET_SIZE(*utf16) / 2 - 1, &r);
+      break;
+    }
   }
-  return array;
+  if (status != napi_ok) throw Error::New(env);
+  return Napi::Value(env, r);
 }
 
-Napi::Value PyObjectWrap::_ToJS_Dir(Napi::Env env, const PyWeakRef &py, NapiObjectStore &store, ToJSOpts opts) {
-  Napi::Object r = Object::New(env);
-  PyStrongRef list = PyObject_Dir(*py);
-  // It seems that some system modules are hidden, we return an empty array
-  if (list == nullptr) {
-    PyErr_Clear();
-    return r;
-  }
-  size_t len = PyList_Size(*list);
-  store.insert({*py, r});
-
-  for (size_t i = 0; i < len; i++) {
-    PyWeakRef key = PyList_GetItem(*list, i);
-    EXCEPTION_CHECK(env, key);
-    PyStrongRef value = PyObject_GetAttr(*py, *key);
-    // dir(module) can reference modules that are not installed
-    // Typical examples are queue/tkinter or dbm/gdbm
-    // (reading this value leads to an exception in Python too)
-    if (value == nullptr) {
-      PyErr_Clear();
-      continue;
-    }
+// Copies larger than this release the GIL
+static constexpr Py_ssize_t unlocked_copy_threshold = 1024 * 1024;
 
-    VERBOSE_PYOBJ(OBJS, *key, "key");
-    Napi::Value jsKey = _ToJS(env, key, store, {opts.depth - 1, opts.buffer});
-    Napi::Value jsValue = _ToJS(env, value, store, {opts.depth - 1, opts.buffer});
-    r.Set(jsKey, jsValue);
+Napi::Value PyObjectWrap::_ToJS_Buffer(Napi::Env env, const PyWeakRef &py, ToJSOpts opts, bool top) {
+  if (opts.shared) {
+    Napi::Value shared = _ToJS_SharedBuffer(env, py);
+    if (!shared.IsEmpty()) return shared;
   }
-  return r;
-}
 
-Napi::Value PyObjectWrap::_ToJS_Buffer(Napi::Env env, const PyWeakRef &py, NapiObjectStore &store) {
   Py_buffer view;
   int status = PyObject_GetBuffer(*py, &view, PyBUF_C_CONTIGUOUS);
   EXCEPTION_CHECK(env, status);
 
-  // V8 doesn't like multiple Buffers that point to the same memory location
-  // https://github.com/nodejs/node/issues/32463
-  // For this reason it is impossible to implement shared Buffers between Python and JS
-  Napi::Value buffer = Buffer<char>::Copy(env, reinterpret_cast<char *>(view.buf), view.len);
+  Napi::Value buffer;
+  if (view.len >= unlocked_copy_threshold && top) {
+    // The exported memory cannot be resized or freed while the Py_buffer is held
+    auto copy = Buffer<char>::New(env, view.len);
+    Py_BEGIN_ALLOW_THREADS;
+    memcpy(copy.Data(), view.buf, view.len);
+    Py_END_ALLOW_THREADS;
+    buffer = copy;
+  } else {
+    buffer = Buffer<char>::Copy(env, reinterpret_cast<char *>(view.buf), view.len);
+  }
   PyBuffer_Release(&view);
   return buffer;
 }
 
+// Called by V8 when the ArrayBuffer is garbage-collected
+static void SharedBuffer_Finalizer(napi_env env, void *data, void *hint) {
+  auto view = static_cast<Py_buffer *>(hint);
+  // Skip if Python has been shut down
+  // Refer to the comment in PyObject::~PyObject about https://github.com/nodejs/node/issues/45088
+  if (active_environments == 0) {
+    delete view;
+    return;
+  }
+
+  auto context = Napi::Env(env).GetInstanceData<EnvContext>();
+  auto it = context->shared_buffers.find(data);
+  if (it != context->shared_buffers.end() && it->second.view == view) {
+    delete it->second.ref;
+    context->shared_buffers.erase(it);
+  }
+
+  PyGILGuard pyGilGuard;
+  VERBOSE_PYOBJ(MEMV, view->obj, "shared buffer release");
+  PyBuffer_Release(view);
+  delete view;
+}
+
+// V8 doesn't like multiple Buffers that point to the same memory location
+// https://github.com/nodejs/node/issues/32463
+// Every address is exported only once, the ArrayBuffer keeps the Py_buffer
+// until it is garbage-collected and the following exports of the same memory
+// reuse it
+// Returns an empty value when the memory cannot be shared and must be copied:
+// * read-only buffers (bytes) - JS cannot protect them
+// * an ArrayBuffer that is shorter than the new export or that is being collected
+// * runtimes that do not support external buffers
+Napi::Value PyObjectWrap::_ToJS_SharedBuffer(Napi::Env env, const PyWeakRef &py) {
+  auto view = new Py_buffer;
+  if (PyObject_GetBuffer(*py, view, PyBUF_C_CONTIGUOUS | PyBUF_WRITABLE) != 0) {
+    PyErr_Clear();
+    delete view;
+    return Napi::Value();
+  }
+  size_t len = static_cast<size_t>(view->len);
+  if (len == 0) {
+    PyBuffer_Release(view);
+    delete view;
+    return Napi::Value();
+  }
+
+  auto context = env.GetInstanceData<EnvContext>();
+  ArrayBuffer arraybuffer;
+  auto it = context->shared_buffers.find(view->buf);
+  if (it != context->shared_buffers.end()) {
+    // The existing export keeps the memory
+    arraybuffer = it->second.ref->Value();
+    PyBuffer_Release(view);
+    delete view;
+    if (arraybuffer.IsEmpty() || arraybuffer.ByteLength() < len) return Napi::Value();
+    VERBOSE_PYOBJ(MEMV, *py, "shared buffer reuse");
+  } else {
+    napi_value raw;
+    napi_status status = napi_create_external_arraybuffer(env, view->buf, len, SharedBuffer_Finalizer, view, &raw);
+    if (status != napi_ok) {
+      PyBuffer_Release(view);
+      delete view;
+      return Napi::Value();
+    }
+    arraybuffer = ArrayBuffer(env, raw);
+    auto ref = new Reference<ArrayBuffer>(Weak(arraybuffer));
+    context->shared_buffers.insert({view->buf, {ref, view}});
+    VERBOSE_PYOBJ(MEMV, *py, "shared buffer new");
+  }
+
+  return context->buffer_from->Call(
+    {arraybuffer, Number::New(env, 0), Number::New(env, static_cast<double>(len))});
+}
+
 Napi::Value PyObjectWrap::ToJS(Napi::Env env, const PyWeakRef &py, ToJSOpts opts) {
-  NapiObjectStore store;
-  return _ToJS(env, py, store, opts);
+  return _ToJS_Run(env, py, opts, false);
 }
 
 Napi::Value PyObjectWrap::ToJS(const CallbackInfo &info) {
   Napi::Env env = info.Env();
   PyGILGuard pyGilGuard;
+  UpdateMemoryHint(env);
 
-  ToJSOpts opts = {-1, true};
+  ToJSOpts opts = {-1, true, false};
+  bool lazy = false;
   Object js_opts = NAPI_OPT_ARG_OBJECT(0);
   if (!js_opts.IsEmpty()) {
-    if (js_opts.Has("buffer")) opts.buffer = js_opts.Get("buffer").ToBoolean().Value();
+    if (js_opts.Has("lazy")) lazy = js_opts.Get("lazy").ToBoolean().Value();
+    if (js_opts.Has("buffer")) {
+      Napi::Value buffer = js_opts.Get("buffer");
+      if (buffer.IsString() && buffer.As<Napi::String>().Utf8Value() == "shared") {
+        opts.shared = true;
+      } else {
+        opts.buffer = buffer.ToBoolean().Value();
+      }
+    }
     if (js_opts.Has("depth")) {
       float depth = js_opts.Get("depth").ToNumber().FloatValue();
       if (!std::isinf(depth)) opts.depth = js_opts.Get("depth").ToNumber().Int32Value();
     }
   }
 
+  if (lazy) return _ToJS_Lazy(env, self, opts);
   return PyObjectWrap::ToJS(env, self, opts);
 }
@@ -30,6 +30,14 @@ describe('array', () => {
     assert.strictEqual(a.item(4).toJS(), 4);
   });
 
+  it('character arrays', () => {
+    const a = array.array('u', 'abc');
+
+    const t = toTypedArray(a) as TypedArray;
+    assert.lengthOf(t, 3);
+    assert.equal(t[1], 'b'.charCodeAt(0));
+  });
+
   for (const cons of tests) {
     describe(cons.name, () => {
       it('export to TypedArray', () => {
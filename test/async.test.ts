@@ -1,4 +1,4 @@
-import { pymport, PyObject } from 'pymport';
+import { pymport, pyval, PyObject, asyncCallStats } from 'pymport';
 import * as path from 'path';
 import { Worker } from 'worker_threads';
 import { assert } from 'chai';
@@ -68,6 +68,30 @@ describe('callAsync', () => {
     });
   });
 
+  it('callMethodAsync()', async () => {
+    const r = await np.callMethodAsync('arange', 6);
+    assert.deepEqual((await r.callMethodAsync('reshape', [2, 3])).callMethod('tolist').toJS(), [[0, 1, 2], [3, 4, 5]]);
+    try {
+      await r.callMethodAsync('no_such_method');
+      assert.fail('Not expected to succeed');
+    } catch (err) {
+      assert.match(String(err), /has no attribute/);
+    }
+  });
+
+  it('callManyAsync()', async () => {
+    const fn = pyval('lambda a, b=1: a * b');
+    assert.deepEqual(await fn.callManyAsync([[1], [2, 3], [4, { b: 5 }]], { toJS: true }), [1, 6, 20]);
+    const r = await fn.callManyAsync([[7]]);
+    assert.instanceOf(r[0], PyObject);
+    try {
+      await fn.callManyAsync([[1], [null], [2]]);
+      assert.fail('Not expected to succeed');
+    } catch (err) {
+      assert.match(String(err), /unsupported operand/);
+    }
+  });
+
   describe('worker_threads', () => {
     function spawnWorker(script: string) {
       return new Promise((resolve, reject) => {
@@ -92,3 +116,97 @@ describe('callAsync', () => {
     });
   });
 });
+
+describe('fire-and-forget callbacks', () => {
+  const loop = pyval('lambda f, n: [f(i) for i in range(n)]');
+  const drain = async (seen: number[], n: number) => {
+    for (let i = 0; i < 100 && seen.length < n; i++) await new Promise((resolve) => setTimeout(resolve, 10));
+  };
+
+  it('queues the calls from a worker thread', async () => {
+    const seen: number[] = [];
+    const fn = PyObject.func((i: PyObject) => seen.push(i.toJS()), { mode: 'async', queue: 4 });
+    const r = await loop.callAsync(fn, 50);
+    assert.deepEqual(r.toJS(), new Array(50).fill(null));
+    await drain(seen, 50);
+    assert.deepEqual(seen, Array.from({ length: 50 }, (_, i) => i));
+  });
+
+  it('drops the calls when the queue is full', async () => {
+    const seen: number[] = [];
+    const fn = PyObject.func((i: PyObject) => seen.push(i.toJS()), { mode: 'async', queue: 1, overflow: 'drop' });
+    loop.call(fn, 10);
+    assert.lengthOf(seen, 0);
+    await drain(seen, 1);
+    await new Promise((resolve) => setTimeout(resolve, 10));
+    assert.deepEqual(seen, [0]);
+    assert.deepEqual(asyncCallStats(fn), { limit: 1, queued: 0, dropped: 9 });
+    assert.throws(() => asyncCallStats(PyObject.func(() => 0)), /async pymport.js_function/);
+  });
+
+  it('throws on invalid options', () => {
+    assert.throws(() => PyObject.func(() => 0, { mode: 'never' as 'async' }), /mode must be/);
+    assert.throws(() => PyObject.func(() => 0, { mode: 'async', queue: 0 }), /positive number/);
+    assert.throws(() => PyObject.func(() => 0, { mode: 'async', overflow: 'x' as 'drop' }), /overflow must be/);
+  });
+});
+
+describe('async iterators', () => {
+  it('for await', async () => {
+    const gen = pyval('(x * 2 for x in range(200))');
+    const result: number[] = [];
+    for await (const el of gen) {
+      assert.instanceOf(el, PyObject);
+      result.push(el.toJS());
+    }
+    assert.lengthOf(result, 200);
+    assert.equal(result[199], 398);
+  });
+
+  it('iterables and batches', async () => {
+    const result: number[] = [];
+    for await (const el of PyObject.list([1, 2, 3, 4, 5]).iterAsync({ batch: 2 })) result.push(el.toJS());
+    assert.deepEqual(result, [1, 2, 3, 4, 5]);
+  });
+
+  it('break', async () => {
+    const gen = pyval('(x for x in range(1000))');
+    let count = 0;
+    for await (const el of gen.iterAsync({ batch: 10 })) {
+      if (el.toJS() === 5) break;
+      count++;
+    }
+    assert.equal(count, 5);
+  });
+
+  it('exception', async () => {
+    const gen = pyval('(1 // x for x in [1, 1, 0, 1])');
+    const result: number[] = [];
+    try {
+      for await (const el of gen) result.push(el.toJS());
+      assert.fail('Not expected to succeed');
+    } catch (err) {
+      assert.match((err as Error).message, /division by zero/);
+    }
+    assert.deepEqual(result, [1, 1]);
+  });
+
+  it('concurrent next()', async () => {
+    const it = pyval('(x for x in range(10))').iterAsync({ batch: 3 });
+    const r = await Promise.all(Array.from({ length: 12 }, () => it.next()));
+    assert.deepEqual(r.slice(0, 10).map((x) => x.value.toJS()), [0, 1, 2, 3, 4, 5, 6, 7, 8, 9]);
+    assert.isTrue(r[10].done);
+    assert.isTrue(r[11].done);
+  });
+
+  it('nextAsync()', async () => {
+    const it = pyval('iter([1, 2, 3])');
+    const first = await it.nextAsync(2);
+    assert.deepEqual(first.values.map((el) => el.toJS()), [1, 2]);
+    assert.isFalse(first.done);
+    const second = await it.nextAsync(2);
+    assert.deepEqual(second.values.map((el) => el.toJS()), [3]);
+    assert.isTrue(second.done);
+    assert.throws(() => PyObject.list([1]).nextAsync(), /not an iterator/);
+  });
+});
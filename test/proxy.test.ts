@@ -232,6 +232,37 @@ describe('proxy', () => {
     });
   });
 
+  describe('methods', () => {
+    it('are called without creating a bound method', () => {
+      const list = PyObject.list([3, 1, 2]);
+      const get = rawPyObject.prototype.get;
+      let calls = 0;
+      rawPyObject.prototype.get = function (this: rawPyObject, name: string) {
+        calls++;
+        return get.call(this, name);
+      };
+      try {
+        list.append(4);
+        list.sort();
+        const detached = list.index;
+        assert.strictEqual(detached(4).toJS(), 3);
+      } finally {
+        rawPyObject.prototype.get = get;
+      }
+      assert.strictEqual(calls, 0);
+      assert.deepEqual(list.toJS(), [1, 2, 3, 4]);
+    });
+
+    it('detached methods keep their function', () => {
+      const obj = pyval('type("T", (), {"m": lambda self: 1})()');
+      const m = obj.m;
+      pyval('setattr(type(o), "m", lambda self: 2)', { o: obj.__PyObject__ });
+      assert.strictEqual(m().toJS(), 1);
+      assert.strictEqual(obj.m().toJS(), 2);
+      assert.strictEqual(obj.m.__PyObject__.type, 'method');
+    });
+  });
+
   describe('class', () => {
     it('class w/ static member', () => {
       const klass = pymport('python_helpers').SomeClass;
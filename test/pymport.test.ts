@@ -1,5 +1,8 @@
 /* eslint-disable @typescript-eslint/no-unused-expressions */
-import { pymport, PyObject, PythonError, version } from 'pymport';
+import {
+  pymport, pyval, PyObject, PythonError, version, backgroundRelease, releaseStats, memoryAccounting, collectCycles,
+  memoCache, memoStats, proxify
+} from 'pymport';
 import chai from 'chai';
 import spies from 'chai-spies';
 chai.use(spies);
@@ -118,6 +121,35 @@ describe('pymport', () => {
       assert.deepEqual(d.get('to_numpy').call().get('tolist').call().toJS(), [1, 3, 5, NaN, 6, 8]);
     });
 
+    it('toColumns()', () => {
+      const pd = pymport('pandas');
+      const df = pd.get('DataFrame').call({
+        i: [1, 2, 3], f: [0.5, NaN, 1.5], s: ['a', null, 'c'], b: [true, false, true],
+        c: pd.get('Categorical').call(['x', 'y', null])
+      });
+      const cols = df.toColumns();
+      assert.sameMembers(Object.keys(cols), ['i', 'f', 's', 'b', 'c']);
+      assert.instanceOf(cols.i, BigInt64Array);
+      assert.deepEqual(Array.from(cols.i as BigInt64Array), [BigInt(1), BigInt(2), BigInt(3)]);
+      assert.instanceOf(cols.f, Float64Array);
+      assert.deepEqual(Array.from(cols.f as Float64Array), [0.5, NaN, 1.5]);
+      assert.deepEqual(cols.s, ['a', null, 'c']);
+      assert.deepEqual(Array.from(cols.b as Uint8Array), [1, 0, 1]);
+      assert.deepEqual(Array.from(cols.c as Int8Array), [0, 1, -1]);
+      assert.deepEqual((cols.c as Int8Array & { categories: string[]; }).categories, ['x', 'y']);
+      assert.deepEqual(Array.from((cols.c as Int8Array & { valid: Uint8Array; }).valid), [1, 1, 0]);
+      assert.isUndefined((cols.i as BigInt64Array & { valid?: Uint8Array; }).valid);
+    });
+
+    it('toColumns() of a dict of arrays', () => {
+      const np = pymport('numpy');
+      const cols = pyval('{"a": np.arange(3, dtype=np.int32), "b": np.ones(2)}', { np }).toColumns();
+      assert.deepEqual(Array.from(cols.a as Int32Array), [0, 1, 2]);
+      assert.deepEqual(Array.from(cols.b as Float64Array), [1, 1]);
+      assert.throws(() => pyval('{"a": np.ones((2, 2))}', { np }).toColumns(), /1-dimensional/);
+      assert.throws(() => PyObject.list([1]).toColumns(), /neither a dict of arrays nor a DataFrame/);
+    });
+
     it('passing a single dict argument', () => {
       const check_dict_arg = pymport('python_helpers').get('single_dict_arg');
       assert.doesNotThrow(() => {
@@ -179,6 +211,12 @@ describe('pymport', () => {
       assert.equal(np.get('ones').toJS(), npJS.ones);
     });
 
+    it('PyObjects cannot be constructed from JS', () => {
+      const Cons = PyObject as unknown as new (...args: unknown[]) => PyObject;
+      assert.throws(() => new Cons(), /empty object/);
+      assert.throws(() => new Cons(42), /PyObject.fromJS/);
+    });
+
     it('member functions on different instances of the same class are identical', () => {
       const np = pymport('numpy');
       const a = np.get('arange').call(6);
@@ -187,6 +225,357 @@ describe('pymport', () => {
     });
   });
 
+  describe('background release', () => {
+    afterEach(() => backgroundRelease(false));
+
+    it('releases the references in a background thread', async () => {
+      backgroundRelease(true);
+      const before = releaseStats().released;
+      (() => {
+        for (let i = 0; i < 1000; i++) PyObject.fromJS({ i });
+      })();
+      global.gc!();
+      for (let i = 0; i < 100 && releaseStats().depth > 0; i++)
+        await new Promise((resolve) => setTimeout(resolve, 10));
+
+      const stats = releaseStats();
+      assert.isTrue(stats.enabled);
+      assert.isAbove(stats.released, before);
+      assert.isAbove(stats.batches, 0);
+      assert.strictEqual(stats.depth, 0);
+      assert.isAtLeast(stats.maxDrainTime, stats.lastDrainTime);
+    });
+
+    it('throws on invalid value', () => {
+      assert.throws(() => backgroundRelease('yes' as unknown as boolean), /must be a boolean/);
+    });
+  });
+
+  describe('memo cache', () => {
+    afterEach(() => memoCache(false));
+
+    it('returns the same frozen array for an immutable object', () => {
+      memoCache(true);
+      const before = memoStats();
+      const py = pyval('(1, "a", (2.5, None), frozenset([3]))');
+      const a = py.toJS();
+      const b = py.toJS();
+      assert.strictEqual(a, b);
+      assert.deepEqual(a, [1, 'a', [2.5, null], [3]]);
+      assert.isTrue(Object.isFrozen(a));
+      assert.isTrue(Object.isFrozen(a[2]));
+
+      const stats = memoStats();
+      assert.isTrue(stats.enabled);
+      assert.isAbove(stats.hits, before.hits);
+      assert.isAbove(stats.misses, before.misses);
+      assert.isAtLeast(stats.size, 1);
+    });
+
+    it('does not cache mutable objects', () => {
+      memoCache(true);
+      const py = pyval('(1, [2, 3])');
+      const a = py.toJS();
+      assert.notStrictEqual(py.toJS(), a);
+      assert.isFalse(Object.isFrozen(a));
+    });
+
+    it('caches the immutable elements of a mutable object', () => {
+      memoCache(true);
+      const py = pyval('(lambda t: ((t, [1]), t))((1, (2, 3)))');
+      const a = py.toJS();
+      assert.deepEqual(a, [[[1, [2, 3]], [1]], [1, [2, 3]]]);
+      assert.isFalse(Object.isFrozen(a));
+      assert.isFalse(Object.isFrozen(a[0]));
+      assert.isTrue(Object.isFrozen(a[1]));
+      assert.strictEqual(a[0][0], a[1]);
+      assert.strictEqual(py.toJS()[1], a[1]);
+    });
+
+    it('drops the entries when disabled', () => {
+      memoCache(true);
+      pyval('(1, 2)').toJS();
+      memoCache(false);
+      assert.strictEqual(memoStats().size, 0);
+    });
+
+    it('throws on invalid value', () => {
+      assert.throws(() => memoCache('yes' as unknown as boolean), /must be a boolean/);
+    });
+  });
+
+  describe('memory accounting', () => {
+    afterEach(() => memoryAccounting('estimate'));
+
+    it('reports the size of the buffer of a numpy array', () => {
+      const np = pymport('numpy');
+      const before = process.memoryUsage().external;
+      const a = np.get('zeros').call(16 * 1024 * 1024);
+      assert.isAbove(process.memoryUsage().external - before, 120 * 1024 * 1024);
+      assert.strictEqual(a.get('nbytes').toJS(), 128 * 1024 * 1024);
+    });
+
+    it('refreshes the size of the containers', () => {
+      const list = PyObject.list([]);
+      const before = process.memoryUsage().external;
+      // The temporary list is never wrapped
+      pyval('l.extend([None] * 1048576)', { l: list });
+      assert.strictEqual(list.length, 1024 * 1024);
+      assert.isAbove(process.memoryUsage().external - before, 4 * 1024 * 1024);
+    });
+
+    it('tracemalloc mode', () => {
+      memoryAccounting('tracemalloc');
+      const tracemalloc = pymport('tracemalloc');
+      assert.isTrue(tracemalloc.get('is_tracing').call().toJS());
+    });
+
+    it('throws on invalid value', () => {
+      assert.throws(() => memoryAccounting('exact' as 'estimate'), /must be/);
+    });
+  });
+
+  describe('lazy toJS()', () => {
+    it('converts only the accessed elements', () => {
+      const data = pyval('{"rows": [{"id": i, "tags": ("a", "b")} for i in range(1000)], "n": 1000, "s": {1}}');
+      const lazy = data.toJS({ lazy: true });
+      assert.equal(lazy.n, 1000);
+      assert.deepEqual(lazy.s, [1]);
+      assert.isTrue(Array.isArray(lazy.rows));
+      assert.lengthOf(lazy.rows, 1000);
+      assert.equal(lazy.rows[999].id, 999);
+      assert.deepEqual(lazy.rows[999].tags, ['a', 'b']);
+      assert.strictEqual(lazy.rows[999], lazy.rows[999]);
+      assert.isUndefined(lazy.rows[1000]);
+      assert.isUndefined(lazy.missing);
+      assert.isTrue('rows' in lazy);
+      assert.isFalse('missing' in lazy);
+      assert.sameMembers(Object.keys(lazy), ['rows', 'n', 's']);
+      assert.deepEqual(lazy.rows.slice(0, 2), [{ id: 0, tags: ['a', 'b'] }, { id: 1, tags: ['a', 'b'] }]);
+      assert.deepEqual(lazy.rows[3], data.item('rows').item(3).toJS());
+    });
+
+    it('depth', () => {
+      const lazy = pyval('[[1, 2], [3]]').toJS({ lazy: true, depth: 1 });
+      assert.lengthOf(lazy, 2);
+      assert.instanceOf(lazy[0], PyObject);
+    });
+
+    it('scalars and dictionaries with other keys are converted eagerly', () => {
+      assert.equal(pyval('42').toJS({ lazy: true }), 42);
+      assert.deepEqual(pyval('{1: "a"}').toJS({ lazy: true }), { 1: 'a' });
+    });
+
+    it('__proto__ is an element', () => {
+      const lazy = pyval('{"__proto__": 1, "a": 2}').toJS({ lazy: true });
+      assert.strictEqual(lazy.__proto__, 1);
+      assert.strictEqual(Object.getPrototypeOf(lazy), Object.prototype);
+      assert.strictEqual(lazy.a, 2);
+    });
+  });
+
+  describe('compiled converters', () => {
+    const schema = { id: 'int', name: 'str', score: 'float?', tags: ['str'], extra: 'any' };
+    const record = { id: 1, name: 'first', score: 2, tags: ['a', 'b'], extra: { x: [1] }, ignored: true };
+
+    it('convert()', () => {
+      const conv = PyObject.compileConverter(schema);
+      const py = conv.convert(record);
+      assert.equal(py.type, 'dict');
+      assert.equal(py.item('score').type, 'float');
+      assert.deepEqual(py.toJS(), { id: 1, name: 'first', score: 2, tags: ['a', 'b'], extra: { x: [1] } });
+      assert.isNull(conv.convert({ ...record, score: undefined }).item('score').toJS());
+      assert.deepEqual(PyObject.compileConverter(['int']).convert([1, 2, 3]).toJS(), [1, 2, 3]);
+    });
+
+    it('call()', () => {
+      const conv = PyObject.compileConverter([schema]);
+      const len = pyval('len');
+      assert.equal(conv.call(len, [record, record]).toJS(), 2);
+    });
+
+    it('call() with named arguments', () => {
+      const conv = PyObject.compileConverter('int');
+      const fn = pyval('lambda *args, **kwargs: (args, kwargs)');
+      assert.deepEqual(conv.call(fn, 1, 2, { a: 3 }).toJS(), [[1, 2], { a: 3 }]);
+      assert.throws(() => conv.call(fn, 1, { a: 'x' }), /mismatch, expected int/);
+      assert.deepEqual(PyObject.compileConverter(schema).call(fn, record, {}).toJS(),
+        [[{ id: 1, name: 'first', score: 2, tags: ['a', 'b'], extra: { x: [1] } }], {}]);
+    });
+
+    it('call() accepts proxified functions', () => {
+      const conv = PyObject.compileConverter(['int']);
+      const sum = proxify(pyval('sum'));
+      assert.strictEqual(conv.call(sum, [1, 2, 3]).toJS(), 6);
+    });
+
+    it('fails fast on mismatch', () => {
+      const conv = PyObject.compileConverter([schema]);
+      assert.throws(() => conv.convert([record, { ...record, tags: ['a', 2] }]),
+        /mismatch at \[1\]\.tags\[1\], expected str/);
+      assert.throws(() => conv.convert([{ ...record, id: 1.5 }]), /mismatch at \[0\]\.id, expected int/);
+      assert.throws(() => conv.convert({}), /mismatch, expected list/);
+      assert.throws(() => PyObject.compileConverter({ id: 'integer' }), /Invalid schema type/);
+      assert.throws(() => PyObject.compileConverter(['int', 'str']), /exactly one element/);
+    });
+  });
+
+  describe('cycle collector', () => {
+    it('collects JS <-> Python cycles', async () => {
+      const weakref = pymport('weakref');
+      let ref: PyObject;
+      (() => {
+        const obj = pyval('type("Holder", (), {})()');
+        pyval('setattr(o, "cb", f)', { o: obj, f: () => obj.toString() });
+        ref = weakref.get('ref').call(obj);
+      })();
+      assert.isNotNull(ref!.call().toJS());
+
+      assert.isAtLeast(collectCycles().weakened, 1);
+      global.gc!();
+      await new Promise((resolve) => setImmediate(resolve));
+      global.gc!();
+      assert.isNull(ref!.call().toJS());
+    });
+
+    it('restores the references rooted in Python', () => {
+      const helpers = pymport('python_helpers');
+      const obj = pyval('type("Holder", (), {})()');
+      pyval('setattr(o, "cb", f)', { o: obj, f: () => 42 });
+      assert.isAtLeast(collectCycles().weakened, 1);
+
+      // Passing the object to Python upgrades the trampoline,
+      // modules are rooted and the next collection does not downgrade it
+      pyval('setattr(m, "rooted", o)', { m: helpers, o: obj });
+      collectCycles();
+      assert.strictEqual(obj.get('cb').call().toJS(), 42);
+      pyval('delattr(m, "rooted")', { m: helpers });
+    });
+
+    it('keeps the functions stored by Python after a collection', async () => {
+      const helpers = pymport('python_helpers');
+      (() => {
+        const obj = pyval('type("Holder", (), {})()');
+        pyval('setattr(o, "cb", f)', { o: obj, f: () => (obj.toString() ? 42 : 0) });
+        assert.isAtLeast(collectCycles().weakened, 1);
+        pyval('setattr(m, "saved", o.cb)', { m: helpers, o: obj });
+      })();
+      global.gc!();
+      await new Promise((resolve) => setImmediate(resolve));
+      global.gc!();
+      assert.strictEqual(pyval('m.saved()', { m: helpers }).toJS(), 42);
+      pyval('delattr(m, "saved")', { m: helpers });
+    });
+
+    it('restores the references of the called functions', () => {
+      const obj = pyval('type("Holder", (), {})()');
+      pyval('setattr(o, "cb", f)', { o: obj, f: () => 42 });
+      assert.isAtLeast(collectCycles().weakened, 1);
+      assert.strictEqual(obj.get('cb').call().toJS(), 42);
+      // It has been strengthened by the call and it is downgraded again
+      assert.isAtLeast(collectCycles().weakened, 1);
+    });
+  });
+
+  describe('callMethod', () => {
+    it('calls a method with positional and named arguments', () => {
+      const np = pymport('numpy');
+      const a = np.callMethod('arange', 6).callMethod('reshape', [2, 3]);
+      assert.deepEqual(a.callMethod('tolist').toJS(), [[0, 1, 2], [3, 4, 5]]);
+      assert.deepEqual(a.callMethod('max', { axis: 1 }).callMethod('tolist').toJS(), [2, 5]);
+      assert.strictEqual(pyval('"a,b"').callMethod('split', ',').toJS().join('-'), 'a-b');
+    });
+
+    it('throws on missing methods and invalid names', () => {
+      const list = pyval('[]');
+      assert.throws(() => list.callMethod('no_such_method'), /has no attribute/);
+      assert.throws(() => list.callMethod(1 as unknown as string), /must be a string/);
+    });
+  });
+
+  describe('callMany', () => {
+    it('calls a function for every argument list', () => {
+      const fn = pyval('lambda a, b=1: a * b');
+      const r = fn.callMany([[1], [2, 3], [4, { b: 5 }]]);
+      assert.lengthOf(r, 3);
+      assert.instanceOf(r[0], PyObject);
+      assert.deepEqual(r.map((v: PyObject) => v.toJS()), [1, 6, 20]);
+      assert.deepEqual(fn.callMany([[2], ['a', 3]], { toJS: true }), [2, 'aaa']);
+      assert.deepEqual(fn.callMany([]), []);
+    });
+
+    it('throws on invalid arguments and Python exceptions', () => {
+      const fn = pyval('lambda a: 1 / a');
+      assert.throws(() => fn.callMany([[1], 2] as unknown as unknown[][]), /must be arrays/);
+      assert.throws(() => fn.callMany([[1], [0]]), /division by zero/);
+      assert.throws(() => pyval('1').callMany([[1]]), /not callable/);
+    });
+  });
+
+  describe('lazy expressions', () => {
+    const np = pymport.lazy(pymport('numpy'));
+
+    it('records and executes an expression', () => {
+      const a = np.arange(6).reshape([2, 3]).T;
+      assert.deepEqual(a.tolist().toJS(), [[0, 3], [1, 4], [2, 5]]);
+      const m = np.matmul(a, np.ones([2, 2], { dtype: np.int16 }));
+      assert.instanceOf(m.run(), PyObject);
+      assert.strictEqual(m.run(), m.run());
+      assert.deepEqual(m.get('tolist').call().toJS(), [[3, 3], [5, 5], [7, 7]]);
+      assert.strictEqual(np.arange(6).tolist().item(np.int64(2)).toJS(), 2);
+    });
+
+    it('await', async () => {
+      const r = await np.arange(3).tolist();
+      assert.instanceOf(r, PyObject);
+      assert.deepEqual(r.toJS(), [0, 1, 2]);
+    });
+
+    it('throws Python exceptions and invalid arguments', async () => {
+      assert.throws(() => np.no_such_function(1).run(), /has no attribute/);
+      try {
+        await np.arange('a');
+        assert.fail('Not expected to succeed');
+      } catch (err) {
+        assert.match(String(err), /Python exception/);
+      }
+      assert.throws(() => pymport.lazy(42 as unknown as PyObject), /must be a PyObject/);
+    });
+  });
+
+  describe('JS function arguments', () => {
+    it('wraps the arguments by default', () => {
+      const fn = PyObject.func(
+        (a: unknown, kw: Record<string, unknown>) => a instanceof PyObject && kw.x instanceof PyObject);
+      assert.isTrue(pyval('f(1, x=2)', { f: fn }).toJS());
+    });
+
+    it('converts the scalars by value', () => {
+      const key = PyObject.func((v: number) => -v, { convert: 'value' });
+      assert.deepEqual(pyval('sorted([3, 1, 2], key=k)', { k: key }).toJS(), [3, 2, 1]);
+      const types = PyObject.func(
+        (...args: unknown[]) => args.map((a) => a instanceof PyObject ? 'PyObject' : typeof a).join(),
+        { convert: 'value' });
+      assert.strictEqual(
+        pyval('f(1, "a", None, 2.5, [1])', { f: types }).toJS(), 'number,string,object,number,PyObject');
+    });
+
+    it('converts the arguments to a depth', () => {
+      const fn = PyObject.func(
+        (a: unknown[], kw: { x: unknown[]; }) => a.length * 10 + kw.x.length, { convert: 1 });
+      assert.strictEqual(pyval('f([[1], [2]], x=[5])', { f: fn }).toJS(), 21);
+      const deep = PyObject.func((a: unknown) => JSON.stringify(a), { convert: Infinity });
+      assert.strictEqual(pyval('f([[1], {"a": "b"}])', { f: deep }).toJS(), '[[1],{"a":"b"}]');
+    });
+
+    it('throws on invalid conversion', () => {
+      assert.throws(() => PyObject.func(() => 0, { convert: 'x' as 'value' }), /convert must be/);
+      assert.throws(() => PyObject.func(() => 0, { convert: NaN }), /non-negative integer/);
+      assert.throws(() => PyObject.func(() => 0, { convert: -1 }), /non-negative integer/);
+      assert.throws(() => PyObject.func(() => 0, { convert: 1.5 }), /non-negative integer/);
+    });
+  });
+
   describe('named arguments', () => {
     it('numpy arguments', () => {
       const np = pymport('numpy');
@@ -216,6 +605,13 @@ describe('pymport', () => {
       assert.deepEqual(max.get('tolist').call().toJS(), [3, 6]);
     });
 
+    it('many positional and named arguments', () => {
+      const fn = pyval('lambda *args, **kwargs: [list(args), kwargs]');
+      const args = Array.from({ length: 12 }, (_, i) => i);
+      assert.deepEqual(fn.call(...args, { x: 'a', y: null }).toJS(), [args, { x: 'a', y: null }]);
+      assert.deepEqual(fn.call(1, 2, undefined).toJS(), [[1, 2], {}]);
+    });
+
     it('JS mode', () => {
       const np = pymport('numpy').toJS();
 
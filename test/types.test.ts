@@ -240,6 +240,28 @@ describe('types', () => {
       assert.throws(() => PyObject.list({ b: 12 } as unknown as number[]), /Argument must be/);
     });
 
+    it('numeric arrays', () => {
+      const numbers = [1, 2.5, -3, 2 ** 40, 1e20, NaN, Infinity];
+      const l = PyObject.list(numbers);
+      assert.deepEqual(pyval('[type(x).__name__ for x in l]', { l }).toJS(),
+        ['int', 'float', 'int', 'int', 'int', 'float', 'float']);
+      assert.equal(l.item(4).toString(), '100000000000000000000');
+      assert.deepEqual(PyObject.list([1, 2.5, NaN]).toJS(), [1, 2.5, NaN]);
+
+      const mixed = PyObject.list([1, 2, 'three', 4, null]);
+      assert.deepEqual(mixed.toJS(), [1, 2, 'three', 4, null]);
+    });
+
+    it('array()', () => {
+      const a = PyObject.array([1, 2.5, -3]);
+      assert.equal(a.type, 'array.array');
+      assert.equal(a.get('typecode').toJS(), 'd');
+      assert.deepEqual(a.get('tolist').call().toJS(), [1, 2.5, -3]);
+      assert.deepEqual(np.get('frombuffer').call(a).get('tolist').call().toJS(), [1, 2.5, -3]);
+      assert.equal(PyObject.array([]).length, 0);
+      assert.throws(() => PyObject.array([1, '2'] as unknown as number[]), /array of numbers/);
+    });
+
     it('circular references', () => {
       const circular: any[] = [];
       circular[0] = circular;
@@ -251,6 +273,36 @@ describe('types', () => {
       assert.equal(d.toString(), '[[...]]');
     });
 
+    it('shared references', () => {
+      const shared = { a: 1 };
+      const s = 'shared string';
+      const d = PyObject.fromJS([shared, shared, s, s, { shared }]);
+      assert.equal(d.item(0).id, d.item(1).id);
+      assert.equal(d.item(0).id, d.item(4).item('shared').id);
+      assert.deepEqual(d.toJS(), [shared, shared, s, s, { shared }]);
+    });
+
+    it('deeply nested lists', () => {
+      const deep = pyval('functools.reduce(lambda a, _: [a], range(100000), [])', { functools: pymport('functools') });
+      let r = deep.toJS();
+      let depth = 0;
+      while (r.length > 0) {
+        r = r[0];
+        depth++;
+      }
+      assert.equal(depth, 100000);
+    });
+
+    it('large results', () => {
+      const large = pyval('(lambda s: [[i, s, {"s": s}] for i in range(20000)])([1])');
+      const r = large.toJS();
+      assert.lengthOf(r, 20000);
+      assert.deepEqual(r[19999], [19999, [1], { s: [1] }]);
+      // The shared references survive the recycling of the handle scopes
+      assert.strictEqual(r[0][1], r[19999][1]);
+      assert.strictEqual(r[19999][1], r[19999][2].s);
+    });
+
     it('iterator', () => {
       assert.deepEqual(toArray(PyObject.list([8, 9, 3])).map(el => el.toJS()), [8, 9, 3]);
     });
@@ -466,6 +518,24 @@ describe('types', () => {
       assert.equal(s.toJS(), '你好');
     });
 
+    it('all string kinds', () => {
+      for (const str of ['', 'ascii', 'latin1 café', 'ucs2 €', 'surrogates 😀 😀']) {
+        const s = PyObject.fromJS(str);
+        assert.equal(s.toJS(), str);
+        assert.equal(s.length, [...str].length);
+        assert.equal(pyval('s + "!"', { s }).toJS(), str + '!');
+      }
+    });
+
+    it('long strings', () => {
+      for (const c of ['a', 'é', '€']) {
+        const str = c.repeat(100000);
+        const s = PyObject.fromJS(str);
+        assert.equal(s.length, str.length);
+        assert.equal(s.toJS(), str);
+      }
+    });
+
     it('toString()', () => {
       const f = PyObject.fromJS('hello');
       assert.equal(f.toString(), 'hello');
@@ -535,6 +605,39 @@ describe('types', () => {
       assert.equal(d.toString(), "{'circular': {...}}");
     });
 
+    it('property names are interned', () => {
+      const records = PyObject.fromJS([{ id: 1, 'клю́ч': 'a' }, { id: 2, 'клю́ч': 'b' }, { 3: 'c' }]);
+      const same = pyval('all(a is b for a, b in zip(r[0], r[1]))', { r: records });
+      assert.isTrue(same.toJS());
+      assert.isTrue(pyval('sys.intern("id") is list(r[0])[0]', { r: records, sys: pymport('sys') }).toJS());
+      assert.deepEqual(records.toJS(), [{ id: 1, 'клю́ч': 'a' }, { id: 2, 'клю́ч': 'b' }, { 3: 'c' }]);
+      assert.equal(records.item(2).item('3').toJS(), 'c');
+    });
+
+    it('lists of records', () => {
+      const records = pyval('[{"id": i, "name": "row" + str(i), "tags": ["t"] * i} for i in range(3)]');
+      assert.deepEqual(records.toJS(), [
+        { id: 0, name: 'row0', tags: [] },
+        { id: 1, name: 'row1', tags: ['t'] },
+        { id: 2, name: 'row2', tags: ['t', 't'] }
+      ]);
+      assert.deepEqual(Object.keys(records.toJS()[2]), ['id', 'name', 'tags']);
+
+      // The rows that do not match the first two are converted as usual
+      const mixed = pyval('[r, {"id": 1, "name": "b"}, {"name": "c", "id": 2}, {"id": 3}, 4, r]',
+        { r: { id: 0, name: 'a' } });
+      const js = mixed.toJS();
+      assert.deepEqual(js, [
+        { id: 0, name: 'a' }, { id: 1, name: 'b' }, { name: 'c', id: 2 }, { id: 3 }, 4, { id: 0, name: 'a' }
+      ]);
+      assert.strictEqual(js[0], js[5]);
+
+      const circular = pyval('(lambda l: l.extend([{"l": l}, {"l": l}]) or l)([])');
+      const r = circular.toJS();
+      assert.strictEqual(r[0].l, r);
+      assert.strictEqual(r[1].l, r);
+    });
+
     it('returns undefined for non-existing attributes', () => {
       const obj = PyObject.fromJS({ test: 'test' });
       assert.isUndefined(obj.get('notAtest'));
@@ -860,6 +963,34 @@ describe('types', () => {
       del.get('delete_arg').call(mv);
     });
 
+    it('TypedArray fromJS() shares memory', () => {
+      const f64 = new Float64Array([1.5, 2.5, 3.5]);
+      const mv = PyObject.fromJS(f64);
+      assert.equal(mv.type, 'memoryview');
+      assert.equal(mv.get('format').toJS(), 'd');
+      assert.equal(mv.get('itemsize').toJS(), 8);
+      assert.equal(mv.length, 3);
+
+      const a = np.get('frombuffer').call(mv, { dtype: 'float64' });
+      assert.deepEqual(a.get('tolist').call().toJS(), [1.5, 2.5, 3.5]);
+      pyval('a.__setitem__(1, 42)', { a });
+      assert.equal(f64[1], 42);
+
+      const i32 = new Int32Array([1, -2, 3]).subarray(1);
+      assert.equal(PyObject.fromJS(i32).get('format').toJS(), 'i');
+      assert.deepEqual(PyObject.fromJS(i32).get('tolist').call().toJS(), [-2, 3]);
+    });
+
+    it('DataView and ArrayBuffer fromJS()', () => {
+      const ab = new ArrayBuffer(8);
+      const mv = PyObject.fromJS(new DataView(ab, 4));
+      assert.equal(mv.get('format').toJS(), 'B');
+      assert.equal(mv.length, 4);
+      pyval('mv.__setitem__(0, 255)', { mv });
+      assert.equal(new Uint8Array(ab)[4], 255);
+      assert.equal(PyObject.fromJS(ab).length, 8);
+    });
+
     it('non-contiguous arrays', () => {
       const a = np.get('zeros').call([2, 3]).get('T');
       assert.throws(() => {
@@ -873,6 +1004,62 @@ describe('types', () => {
       }, /contiguous/);
     });
 
+    it('shared Buffers', () => {
+      const a = np.get('zeros').call(4, { dtype: 'uint8' });
+      const buf = a.toJS({ buffer: 'shared' });
+      assert.instanceOf(buf, Buffer);
+      assert.equal(buf.length, 4);
+      pyval('a.__setitem__(1, 42)', { a });
+      assert.equal(buf[1], 42);
+      buf[2] = 17;
+      assert.equal(a.get('tolist').call().toJS()[2], 17);
+
+      // The same memory is exported once
+      const again = a.toJS({ buffer: 'shared' });
+      assert.strictEqual(again.buffer, buf.buffer);
+      const head = pyval('a[:2]', { a }).toJS({ buffer: 'shared' });
+      assert.strictEqual(head.buffer, buf.buffer);
+      assert.equal(head.length, 2);
+
+      // Read-only buffers are copied
+      const bytes = PyObject.bytes(Buffer.from('abc'));
+      assert.equal(bytes.toJS({ buffer: 'shared' }).toString(), 'abc');
+
+      // Nested buffers
+      const nested = PyObject.fromJS({ a }).toJS({ buffer: 'shared' });
+      assert.strictEqual(nested.a.buffer, buf.buffer);
+    });
+
+    it('toTypedArray()', () => {
+      const a = np.get('arange').call(6, { dtype: 'float32' }).get('reshape').call(2, 3);
+      const t = a.toTypedArray();
+      assert.instanceOf(t, Float32Array);
+      assert.deepEqual(Array.from(t), [0, 1, 2, 3, 4, 5]);
+      assert.deepEqual(t.shape, [2, 3]);
+      assert.deepEqual(t.strides, [3, 1]);
+
+      const tr = a.get('T').toTypedArray();
+      assert.deepEqual(Array.from(tr), [0, 3, 1, 4, 2, 5]);
+      assert.deepEqual(tr.shape, [3, 2]);
+
+      const step = pyval('np.arange(10, dtype=np.int64)[::-3]', { np }).toTypedArray();
+      assert.instanceOf(step, BigInt64Array);
+      assert.deepEqual(Array.from(step), [9, 6, 3, 0].map(BigInt));
+
+      assert.throws(() => PyObject.fromJS(1).toTypedArray(), /Buffer protocol/);
+      assert.throws(() => np.get('zeros').call(2, { dtype: 'complex64' }).toTypedArray(), /not supported/);
+    });
+
+    it('toTypedArray() of a large non-contiguous array', () => {
+      const a = pyval('np.arange(4000000, dtype=np.float64).reshape(2000, 2000).T', { np });
+      const t = a.toTypedArray();
+      assert.instanceOf(t, Float64Array);
+      assert.lengthOf(t, 4000000);
+      assert.equal(t[1], 2000);
+      assert.equal(t[2000], 1);
+      assert.equal(t[3999999], 3999999);
+    });
+
     it('numpy round-trip conversion through the Buffer protocol', () => {
       const py = np.get('ones').call(6);
       const js = py.get('tolist').call().toJS();  // to JS array